@@ -0,0 +1,536 @@
+#pragma warning(disable: 4101)
+
+#include "txn.h"
+
+
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+# include <windows.h>
+# include <psapi.h>
+#else
+# include <sys/resource.h>
+#endif
+
+
+
+
+#if defined(__GLIBC__)
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+static u64 s_allocCount = 0;
+
+void* malloc(size_t size)
+{
+    ++s_allocCount;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size)
+{
+    ++s_allocCount;
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    ++s_allocCount;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+
+static s64 allocCount(void)
+{
+    return (s64)s_allocCount;
+}
+
+#else
+
+static s64 allocCount(void)
+{
+    return -1;
+}
+
+#endif
+
+
+
+
+static f64 timeNow(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (f64)c.QuadPart / (f64)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+#endif
+}
+
+
+static s64 peakRssKB(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    {
+        return -1;
+    }
+    return (s64)(pmc.PeakWorkingSetSize / 1024);
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+    {
+        return -1;
+    }
+# ifdef __APPLE__
+    return (s64)(ru.ru_maxrss / 1024);
+# else
+    return (s64)ru.ru_maxrss;
+# endif
+#endif
+}
+
+
+
+
+
+
+
+
+typedef struct BenchOpt
+{
+    u32 depth;
+    u32 fanout;
+    u32 tokLen;
+    f64 quoteDensity;
+    f64 escapeDensity;
+    f64 commentDensity;
+    u32 lineLen;
+    u32 sizeKB;
+    u32 iters;
+    u32 seed;
+} BenchOpt;
+
+
+typedef struct BenchGen
+{
+    const BenchOpt* opt;
+    u64 rng;
+    u32 column;
+    vec_char text[1];
+} BenchGen;
+
+
+
+static u32 benchRand(BenchGen* gen)
+{
+    u64 x = gen->rng;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    gen->rng = x;
+    return (u32)(x >> 32);
+}
+
+static f64 benchRandF(BenchGen* gen)
+{
+    return (f64)benchRand(gen) / 4294967296.0;
+}
+
+static void benchPutCh(BenchGen* gen, char c)
+{
+    vec_push(gen->text, c);
+    gen->column = ('\n' == c) ? 0 : gen->column + 1;
+}
+
+static void benchPutStr(BenchGen* gen, const char* s)
+{
+    while (*s)
+    {
+        benchPutCh(gen, *s++);
+    }
+}
+
+static void benchSep(BenchGen* gen)
+{
+    const BenchOpt* opt = gen->opt;
+    if (benchRandF(gen) < opt->commentDensity)
+    {
+        if (benchRand(gen) & 1)
+        {
+            benchPutStr(gen, " // comment line\n");
+        }
+        else
+        {
+            benchPutStr(gen, " /* block comment */ ");
+        }
+    }
+    else if (opt->lineLen && (gen->column >= opt->lineLen))
+    {
+        benchPutCh(gen, '\n');
+    }
+    else
+    {
+        benchPutCh(gen, ' ');
+    }
+}
+
+static void benchGenTok(BenchGen* gen)
+{
+    static const char alpha[] = "abcdefghijklmnopqrstuvwxyz0123456789_-+<>=!?*/";
+    static const char escs[] = "()[]{}\"' ";
+    const BenchOpt* opt = gen->opt;
+    u32 len = 1 + benchRand(gen) % (opt->tokLen * 2);
+    if (benchRandF(gen) < opt->quoteDensity)
+    {
+        benchPutCh(gen, '"');
+        for (u32 i = 0; i < len; ++i)
+        {
+            if (benchRandF(gen) < opt->escapeDensity)
+            {
+                benchPutCh(gen, '\\');
+                benchPutCh(gen, escs[benchRand(gen) % (sizeof(escs) - 1)]);
+            }
+            else
+            {
+                benchPutCh(gen, alpha[benchRand(gen) % (sizeof(alpha) - 1)]);
+            }
+        }
+        benchPutCh(gen, '"');
+    }
+    else
+    {
+        benchPutCh(gen, alpha[benchRand(gen) % (sizeof(alpha) - 3)]);
+        for (u32 i = 1; i < len; ++i)
+        {
+            benchPutCh(gen, alpha[benchRand(gen) % (sizeof(alpha) - 1)]);
+        }
+    }
+}
+
+static void benchGenNode(BenchGen* gen, u32 depth)
+{
+    const BenchOpt* opt = gen->opt;
+    if ((depth >= opt->depth) || (benchRand(gen) % 3 == 0))
+    {
+        benchGenTok(gen);
+        return;
+    }
+    static const char brackets[] = "()[]{}";
+    u32 b = benchRand(gen) % 3;
+    benchPutCh(gen, brackets[b * 2]);
+    u32 n = 1 + benchRand(gen) % (opt->fanout * 2);
+    for (u32 i = 0; i < n; ++i)
+    {
+        if (i > 0)
+        {
+            benchSep(gen);
+        }
+        benchGenNode(gen, depth + 1);
+    }
+    benchPutCh(gen, brackets[b * 2 + 1]);
+}
+
+static void benchGen(BenchGen* gen)
+{
+    const BenchOpt* opt = gen->opt;
+    gen->rng = 0x9E3779B97F4A7C15ull ^ opt->seed;
+    u64 size = (u64)opt->sizeKB * 1024;
+    while (gen->text->length < size)
+    {
+        benchGenNode(gen, 0);
+        benchPutCh(gen, '\n');
+    }
+    vec_push(gen->text, 0);
+    --gen->text->length;
+}
+
+
+
+
+
+
+
+
+static void benchReport
+(
+    const char* name, const BenchOpt* opt, u32 bytes, u32 nodes, u32 iters, f64 sec, s64 allocs, bool srcInfo
+)
+{
+    f64 mb = (f64)bytes * iters / (1024.0 * 1024.0);
+    printf
+    (
+        "{\"bench\":\"%s\",\"srcInfo\":%s,\"depth\":%u,\"fanout\":%u,\"tokLen\":%u,"
+        "\"quoteDensity\":%g,\"escapeDensity\":%g,\"commentDensity\":%g,\"lineLen\":%u,"
+        "\"bytes\":%u,\"nodes\":%u,\"iters\":%u,\"sec\":%.6f,\"MBps\":%.3f,\"nodesps\":%.0f,"
+        "\"allocs\":%lld,\"peakRssKB\":%lld}\n",
+        name, srcInfo ? "true" : "false", opt->depth, opt->fanout, opt->tokLen,
+        opt->quoteDensity, opt->escapeDensity, opt->commentDensity, opt->lineLen,
+        bytes, nodes, iters, sec, (sec > 0) ? mb / sec : 0, (sec > 0) ? (f64)nodes * iters / sec : 0,
+        (long long)allocs, (long long)peakRssKB()
+    );
+    fflush(stdout);
+}
+
+
+// benchmarks run in release builds, so failures are checked at runtime rather than asserted
+static void benchCheck(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "%s failed\n", what);
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+
+
+static void benchStats(const char* text)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_SpaceSrcInfo srcInfo[1] = { 0 };
+    TXN_Node root = TXN_parseAsList(space, text, srcInfo);
+    benchCheck(root.id != TXN_Node_Invalid.id, "parse");
+    TXN_PrintMlOpt mlOpt[1] = { 4, 80, srcInfo };
+    TXN_printSL(space, root, NULL, 0, srcInfo);
+    TXN_printML(space, root, NULL, 0, mlOpt);
+
+    TXN_Stats stats[1];
+    if (TXN_spaceStats(space, stats))
+    {
+        printf
+        (
+            "{\"bench\":\"stats\",\"textToks\":%llu,\"stringToks\":%llu,\"seqToks\":%llu,"
+            "\"spaceBytes\":%llu,\"commentBytes\":%llu,\"poolHits\":%llu,\"poolInserts\":%llu,"
+            "\"vecGrows\":%llu,\"maxDepth\":%u",
+            (unsigned long long)stats->textToks, (unsigned long long)stats->stringToks,
+            (unsigned long long)stats->seqToks, (unsigned long long)stats->spaceBytes,
+            (unsigned long long)stats->commentBytes, (unsigned long long)stats->poolHits,
+            (unsigned long long)stats->poolInserts, (unsigned long long)stats->vecGrows, stats->maxDepth
+        );
+        for (u32 i = 0; i < TXN_NumStatsPhases; ++i)
+        {
+            printf(",\"cycles%s\":%llu", TXN_StatsPhaseNameTable(i), (unsigned long long)stats->cycles[i]);
+        }
+        printf("}\n");
+    }
+
+    TXN_spaceSrcInfoFree(srcInfo);
+    TXN_spaceFree(space);
+}
+
+
+
+
+static void benchParse
+(
+    const BenchOpt* opt, const char* name, const char* text, bool asCell, bool useSrcInfo, bool prescan
+)
+{
+    u32 bytes = (u32)strlen(text);
+    u32 nodes = 0;
+    s64 allocs0 = allocCount();
+    f64 t0 = timeNow();
+    for (u32 i = 0; i < opt->iters; ++i)
+    {
+        TXN_Space* space = TXN_spaceNew();
+        TXN_spaceSetPrescan(space, prescan);
+        TXN_SpaceSrcInfo srcInfo[1] = { 0 };
+        TXN_Node root = asCell ?
+            TXN_parseAsCell(space, text, useSrcInfo ? srcInfo : NULL) :
+            TXN_parseAsList(space, text, useSrcInfo ? srcInfo : NULL);
+        benchCheck(root.id != TXN_Node_Invalid.id, name);
+        nodes = TXN_spaceNodesTotal(space);
+        TXN_spaceSrcInfoFree(srcInfo);
+        TXN_spaceFree(space);
+    }
+    f64 sec = timeNow() - t0;
+    s64 allocs = (allocs0 < 0) ? -1 : (allocCount() - allocs0) / opt->iters;
+    benchReport(name, opt, bytes, nodes, opt->iters, sec, allocs, useSrcInfo);
+}
+
+
+static void benchPrint(const BenchOpt* opt, const char* text, bool ml, bool useSrcInfo)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_SpaceSrcInfo srcInfo[1] = { 0 };
+    TXN_Node root = TXN_parseAsList(space, text, srcInfo);
+    benchCheck(root.id != TXN_Node_Invalid.id, "parse");
+    u32 nodes = TXN_spaceNodesTotal(space);
+
+    TXN_PrintMlOpt mlOpt[1] = { 4, 80, useSrcInfo ? srcInfo : NULL };
+    u32 size = ml ?
+        TXN_printML(space, root, NULL, 0, mlOpt) :
+        TXN_printSL(space, root, NULL, 0, useSrcInfo ? srcInfo : NULL);
+    char* buf = malloc(size + 1);
+
+    s64 allocs0 = allocCount();
+    f64 t0 = timeNow();
+    for (u32 i = 0; i < opt->iters; ++i)
+    {
+        u32 n = ml ?
+            TXN_printML(space, root, buf, size + 1, mlOpt) :
+            TXN_printSL(space, root, buf, size + 1, useSrcInfo ? srcInfo : NULL);
+        benchCheck(n == size, ml ? "printML" : "printSL");
+    }
+    f64 sec = timeNow() - t0;
+    s64 allocs = (allocs0 < 0) ? -1 : (allocCount() - allocs0) / opt->iters;
+    benchReport(ml ? "printML" : "printSL", opt, size, nodes, opt->iters, sec, allocs, useSrcInfo);
+
+    free(buf);
+    TXN_spaceSrcInfoFree(srcInfo);
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+
+static bool benchBinWrite(void* ctx, const void* data, u32 size)
+{
+    vec_char* out = ctx;
+    vec_pusharr(out, (const char*)data, size);
+    return true;
+}
+
+
+static void benchBin(const BenchOpt* opt, const char* text, bool dict)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, text, NULL);
+    benchCheck(root.id != TXN_Node_Invalid.id, "parse");
+    u32 nodes = TXN_spaceNodesTotal(space);
+    TXN_BinOpt binOpt[1] = { dict };
+
+    vec_char out[1] = { 0 };
+    s64 allocs0 = allocCount();
+    f64 t0 = timeNow();
+    for (u32 i = 0; i < opt->iters; ++i)
+    {
+        vec_clear(out);
+        TXN_binEncode(space, root, binOpt, benchBinWrite, out);
+    }
+    f64 sec = timeNow() - t0;
+    s64 allocs = (allocs0 < 0) ? -1 : (allocCount() - allocs0) / opt->iters;
+    benchReport(dict ? "binEncodeDict" : "binEncode", opt, out->length, nodes, opt->iters, sec, allocs, false);
+
+    allocs0 = allocCount();
+    t0 = timeNow();
+    for (u32 i = 0; i < opt->iters; ++i)
+    {
+        TXN_Space* space1 = TXN_spaceNew();
+        TXN_Node root1 = TXN_binDecode(space1, out->data, out->length, NULL);
+        benchCheck(root1.id != TXN_Node_Invalid.id, dict ? "binDecodeDict" : "binDecode");
+        TXN_spaceFree(space1);
+    }
+    sec = timeNow() - t0;
+    allocs = (allocs0 < 0) ? -1 : (allocCount() - allocs0) / opt->iters;
+    benchReport(dict ? "binDecodeDict" : "binDecode", opt, out->length, nodes, opt->iters, sec, allocs, false);
+
+    vec_free(out);
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+
+static bool benchArg(int argc, char* argv[], int* i, const char* name, f64* out)
+{
+    if (strcmp(argv[*i], name) != 0)
+    {
+        return false;
+    }
+    if (*i + 1 >= argc)
+    {
+        fprintf(stderr, "missing value for %s\n", name);
+        exit(EXIT_FAILURE);
+    }
+    *out = atof(argv[++*i]);
+    return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+    BenchOpt opt[1] = { { 6, 4, 8, 0.1, 0.05, 0.02, 100, 4096, 5, 1 } };
+    for (int i = 1; i < argc; ++i)
+    {
+        f64 v;
+        if (benchArg(argc, argv, &i, "--depth", &v)) opt->depth = (u32)v;
+        else if (benchArg(argc, argv, &i, "--fanout", &v)) opt->fanout = (u32)v;
+        else if (benchArg(argc, argv, &i, "--toklen", &v)) opt->tokLen = (u32)v;
+        else if (benchArg(argc, argv, &i, "--quote", &v)) opt->quoteDensity = v;
+        else if (benchArg(argc, argv, &i, "--escape", &v)) opt->escapeDensity = v;
+        else if (benchArg(argc, argv, &i, "--comment", &v)) opt->commentDensity = v;
+        else if (benchArg(argc, argv, &i, "--width", &v)) opt->lineLen = (u32)v;
+        else if (benchArg(argc, argv, &i, "--size", &v)) opt->sizeKB = (u32)v;
+        else if (benchArg(argc, argv, &i, "--iters", &v)) opt->iters = (u32)v;
+        else if (benchArg(argc, argv, &i, "--seed", &v)) opt->seed = (u32)v;
+        else
+        {
+            fprintf
+            (
+                stderr,
+                "usage: bench [--depth N] [--fanout N] [--toklen N] [--quote F] [--escape F]"
+                " [--comment F] [--width N] [--size KB] [--iters N] [--seed N]\n"
+            );
+            return EXIT_FAILURE;
+        }
+    }
+    if (!opt->fanout) opt->fanout = 1;
+    if (!opt->tokLen) opt->tokLen = 1;
+    if (!opt->iters) opt->iters = 1;
+
+    BenchGen gen[1] = { { opt } };
+    benchGen(gen);
+    const char* list = gen->text->data;
+
+    vec_char cell[1] = { 0 };
+    vec_push(cell, '(');
+    vec_pusharr(cell, list, gen->text->length);
+    vec_push(cell, ')');
+    vec_push(cell, 0);
+
+    benchParse(opt, "parseAsList", list, false, false, false);
+    benchParse(opt, "parseAsList", list, false, true, false);
+    benchParse(opt, "parseAsCell", cell->data, true, false, false);
+    benchParse(opt, "parseAsCell", cell->data, true, true, false);
+    benchParse(opt, "parsePrescan", list, false, false, true);
+    benchParse(opt, "parsePrescan", list, false, true, true);
+    benchPrint(opt, list, false, false);
+    benchPrint(opt, list, false, true);
+    benchPrint(opt, list, true, false);
+    benchPrint(opt, list, true, true);
+    benchBin(opt, list, false);
+    benchBin(opt, list, true);
+    benchStats(list);
+
+    vec_free(cell);
+    vec_free(gen->text);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+#pragma warning(disable: 4101)
+
+#include "txn.h"
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#endif
+
+#include <fileu.h>
+
+
+
+
+static f64 timeNow(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (f64)c.QuadPart / (f64)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+#endif
+}
+
+
+
+
+
+
+
+
+static void benchReport(const char* name, u32 iters, f64 sec, f64 calls)
+{
+    printf
+    (
+        "{\"bench\":\"%s\",\"iters\":%u,\"sec\":%.6f,\"msPerIter\":%.4f,\"callsps\":%.0f}\n",
+        name, iters, sec, (iters > 0) ? sec * 1000.0 / iters : 0, (sec > 0) ? calls * iters / sec : 0
+    );
+    fflush(stdout);
+}
+
+
+static TXN_EvalProgram* benchCompile(TXN_Space* space, const char* src)
+{
+    TXN_Node root = TXN_parseAsList(space, src, NULL);
+    if (root.id == TXN_Node_Invalid.id)
+    {
+        fprintf(stderr, "parse failed\n");
+        exit(EXIT_FAILURE);
+    }
+    TXN_EvalErrInfo err;
+    TXN_EvalProgram* prog = TXN_evalCompile(space, root, &err);
+    if (!prog)
+    {
+        fprintf(stderr, "compile failed: %s\n", TXN_EvalErrNameTable(err.err));
+        exit(EXIT_FAILURE);
+    }
+    return prog;
+}
+
+
+// a file may stop on an eval error by design, its run is then timed up to that error
+static void benchRun(const char* name, const TXN_EvalProgram* prog, u32 iters, f64 calls, bool mayFail)
+{
+    TXN_EvalVM* vm = TXN_evalVmNew(prog);
+    f64 t0 = timeNow();
+    for (u32 i = 0; i < iters; ++i)
+    {
+        TXN_evalStackClear(vm);
+        TXN_evalGc(vm);
+        if (!TXN_evalRun(vm) && !mayFail)
+        {
+            fprintf(stderr, "%s failed: %s\n", name, TXN_EvalErrNameTable(TXN_evalVmErr(vm).err));
+            exit(EXIT_FAILURE);
+        }
+    }
+    f64 sec = timeNow() - t0;
+    benchReport(name, iters, sec, calls);
+    TXN_evalVmFree(vm);
+}
+
+
+
+
+static void benchFile(const char* path, u32 iters)
+{
+    char* text;
+    u32 textSize = FILEU_readFile(path, &text);
+    if (-1 == textSize)
+    {
+        fprintf(stderr, "cannot read %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, text, NULL);
+    if (root.id == TXN_Node_Invalid.id)
+    {
+        fprintf(stderr, "cannot parse %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    f64 t0 = timeNow();
+    for (u32 i = 0; i < iters; ++i)
+    {
+        TXN_evalProgramFree(TXN_evalCompile(space, root, NULL));
+    }
+    benchReport("compile", iters, timeNow() - t0, 0);
+
+    TXN_EvalProgram* prog = benchCompile(space, text);
+    benchRun("run", prog, iters, 0, true);
+    TXN_evalProgramFree(prog);
+    TXN_spaceFree(space);
+    free(text);
+}
+
+
+static void benchFib(u32 n, u32 iters)
+{
+    char src[256];
+    snprintf(src, sizeof(src), "(def fib (var x) (if (gt x 2) (+ (fib (- x 1)) (fib (- x 2))) 1)) (fib %u)", n);
+    f64 a = 1, b = 1;
+    for (u32 i = 2; i < n; ++i)
+    {
+        f64 c = a + b;
+        a = b;
+        b = c;
+    }
+    TXN_Space* space = TXN_spaceNew();
+    TXN_EvalProgram* prog = benchCompile(space, src);
+    benchRun("fib", prog, iters, 2 * b - 1, false);
+    TXN_evalProgramFree(prog);
+    TXN_spaceFree(space);
+}
+
+
+
+// the same pipeline with quotation shapes that have a kernel and with ones that run element by element
+static void benchAry(u32 n, u32 iters)
+{
+    static const char* fmt[2] =
+    {
+        "(& %u) [5 +] map [20 gt] filter [+] reduce",
+        "(& %u) [5 + 0 +] map [20 gt 0 +] filter [+ 0 +] reduce",
+    };
+    static const char* name[2] = { "aryKernel", "aryGeneric" };
+    for (u32 i = 0; i < 2; ++i)
+    {
+        char src[256];
+        snprintf(src, sizeof(src), fmt[i], n);
+        TXN_Space* space = TXN_spaceNew();
+        TXN_EvalProgram* prog = benchCompile(space, src);
+        benchRun(name[i], prog, iters, 3.0 * n, false);
+        TXN_evalProgramFree(prog);
+        TXN_spaceFree(space);
+    }
+}
+
+
+
+
+
+
+
+
+static bool benchArg(int argc, char* argv[], int* i, const char* name, const char** out)
+{
+    if (strcmp(argv[*i], name) != 0)
+    {
+        return false;
+    }
+    if (*i + 1 >= argc)
+    {
+        fprintf(stderr, "missing value for %s\n", name);
+        exit(EXIT_FAILURE);
+    }
+    *out = argv[++*i];
+    return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const char* path = "../1.txn";
+    u32 fib = 20;
+    u32 iters = 20;
+    u32 ary = 1000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* v;
+        if (benchArg(argc, argv, &i, "--file", &v)) path = v;
+        else if (benchArg(argc, argv, &i, "--fib", &v)) fib = (u32)atoi(v);
+        else if (benchArg(argc, argv, &i, "--iters", &v)) iters = (u32)atoi(v);
+        else if (benchArg(argc, argv, &i, "--ary", &v)) ary = (u32)atoi(v);
+        else
+        {
+            fprintf(stderr, "usage: bench_eval [--file PATH] [--fib N] [--ary N] [--iters N]\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if (!iters) iters = 1;
+
+    benchFile(path, iters);
+    benchFib(fib, iters);
+    benchAry(ary, iters);
+    return EXIT_SUCCESS;
+}
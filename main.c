@@ -86,12 +86,1174 @@ static void pp_test(void)
 
 
 
+static bool query_test_collect(void* ctx, TXN_Node node, const TXN_Node* caps, u32 capsTotal)
+{
+    TXN_NodeVec* out = ctx;
+    assert(1 == capsTotal);
+    vec_push(out, caps[0]);
+    return true;
+}
+
+static void query_test(void)
+{
+    char* text;
+    u32 textSize = FILEU_readFile("../1.txn", &text);
+    assert(textSize != -1);
+
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, text, NULL);
+    assert(root.id != TXN_Node_Invalid.id);
+    free(text);
+
+    TXN_Query* query = TXN_queryNew("** (def $ %tok (var ...) ...)");
+    assert(query);
+    assert(1 == TXN_queryCapturesTotal(query));
+
+    TXN_NodeVec names[1] = { 0 };
+    u32 n = TXN_queryExec(query, space, root, NULL, query_test_collect, names);
+    assert(7 == n);
+    assert(0 == strcmp("swap", TXN_tokData(space, names->data[0])));
+    assert(0 == strcmp("apply121", TXN_tokData(space, names->data[6])));
+
+    TXN_TokIndex* index = TXN_tokIndexNew(space, root);
+    vec_resize(names, 0);
+    u32 n1 = TXN_queryExec(query, space, root, index, query_test_collect, names);
+    assert(n == n1);
+    assert(0 == strcmp("swap", TXN_tokData(space, names->data[0])));
+    assert(0 == strcmp("apply121", TXN_tokData(space, names->data[6])));
+    TXN_queryFree(query);
+
+    query = TXN_queryNew("** (if ** (eq ...) _ _)");
+    assert(query);
+    u32 nIndexed = TXN_queryExec(query, space, root, index, NULL, NULL);
+    u32 nScanned = TXN_queryExec(query, space, root, NULL, NULL, NULL);
+    assert(4 == nIndexed);
+    assert(4 == nScanned);
+    TXN_queryFree(query);
+
+    TXN_Query* bad0 = TXN_queryNew("(a ... b)");
+    TXN_Query* bad1 = TXN_queryNew("%unknown");
+    assert(!bad0);
+    assert(!bad1);
+
+    vec_free(names);
+    TXN_tokIndexFree(index);
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static void classify_test(void)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, "50000 -2 +7 1.5 .5e1 2e-3 - + x1 1x 123456789012345678 \"7\" 99999999999999999999", NULL);
+    assert(root.id != TXN_Node_Invalid.id);
+    const TXN_Node* elms = TXN_seqElm(space, root);
+
+    assert(TXN_TokClass_Int == TXN_tokClass(space, elms[0]));
+    assert(50000 == TXN_tokAsI64(space, elms[0]));
+
+    TXN_spaceClassifyToks(space);
+    assert(TXN_TokClass_Int == TXN_tokClass(space, elms[0]));
+    assert(50000 == TXN_tokAsI64(space, elms[0]));
+    assert(-2 == TXN_tokAsI64(space, elms[1]));
+    assert(7 == TXN_tokAsI64(space, elms[2]));
+    assert(TXN_TokClass_Float == TXN_tokClass(space, elms[3]));
+    assert(1.5 == TXN_tokAsF64(space, elms[3]));
+    assert(5.0 == TXN_tokAsF64(space, elms[4]));
+    assert(0.002 == TXN_tokAsF64(space, elms[5]));
+    assert(TXN_TokClass_Ident == TXN_tokClass(space, elms[6]));
+    assert(TXN_TokClass_Ident == TXN_tokClass(space, elms[7]));
+    assert(TXN_TokClass_Ident == TXN_tokClass(space, elms[8]));
+    assert(TXN_TokClass_Ident == TXN_tokClass(space, elms[9]));
+    assert(123456789012345678ll == TXN_tokAsI64(space, elms[10]));
+    assert(TXN_TokClass_String == TXN_tokClass(space, elms[11]));
+    assert(TXN_TokClass_Float == TXN_tokClass(space, elms[12]));
+
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static void str_test(void)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, "\"a\\(b\\\"c\" 'x y' \"\\\\\"", NULL);
+    assert(root.id != TXN_Node_Invalid.id);
+    const TXN_Node* elms = TXN_seqElm(space, root);
+    assert(0 == strcmp("a(b\"c", TXN_tokData(space, elms[0])));
+    assert(5 == TXN_tokSize(space, elms[0]));
+    assert(0 == strcmp("x y", TXN_tokData(space, elms[1])));
+    assert(0 == strcmp("\\", TXN_tokData(space, elms[2])));
+
+    const char* s = "0123456789abcdef(x)[y]{z} 'q' \"Q\"\ttail0123456789abcdef0123456789";
+    TXN_Node tok = TXN_tokFromCstr(space, s, true);
+    char buf[256];
+    u32 n = TXN_printSL(space, tok, buf, sizeof(buf), NULL);
+    assert(n == strlen(buf));
+    assert(0 == strcmp("\"0123456789abcdef\\(x\\)\\[y\\]\\{z\\}\\ \\'q\\'\\ \\\"Q\\\"\\\ttail0123456789abcdef0123456789\"", buf));
+    TXN_Node tok1 = TXN_parseAsCell(space, buf, NULL);
+    assert(0 == strcmp(s, TXN_tokData(space, tok1)));
+    u32 n1 = TXN_printSL(space, tok, NULL, 0, NULL);
+    assert(n == n1);
+    u32 n2 = TXN_printSL(space, tok, buf, 8, NULL);
+    assert(n == n2);
+    assert(7 == strlen(buf));
+
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static void stats_test(void)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, "a /* c */ (b \"s\\ t\" [c]) // x\n", NULL);
+    assert(root.id != TXN_Node_Invalid.id);
+    TXN_Stats stats[1];
+    if (TXN_spaceStats(space, stats))
+    {
+        assert(3 == stats->textToks);
+        assert(1 == stats->stringToks);
+        assert(2 == stats->seqToks);
+        assert(2 == stats->maxDepth);
+        assert(12 == stats->commentBytes);
+        assert(stats->poolInserts > 0);
+        assert(stats->cycles[TXN_StatsPhase_Parse] > 0);
+        TXN_spaceStatsReset(space);
+        TXN_spaceStats(space, stats);
+        assert(0 == stats->textToks);
+    }
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static void mem_test(void)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_SpaceSrcInfo srcInfo[1] = { 0 };
+    TXN_Node root = TXN_parseAsList(space, "(a b c) [a \"b\" (d e f g)] h", srcInfo);
+    assert(root.id != TXN_Node_Invalid.id);
+
+    TXN_SpaceMemReport report[1];
+    TXN_spaceMemReport(space, srcInfo, report);
+    assert(report->nodes.used > 0);
+    assert(report->nodes.reserved >= report->nodes.used);
+    assert(report->pool.used > 0);
+    assert(report->poolElms > 0);
+    assert(report->srcInfoNodes.used > 0);
+    assert(report->total.reserved >= report->total.used);
+
+    TXN_spaceShrinkToFit(space, srcInfo);
+    TXN_SpaceMemReport report1[1];
+    TXN_spaceMemReport(space, srcInfo, report1);
+    assert(report1->nodes.reserved == report1->nodes.used);
+    assert(report1->nodes.used == report->nodes.used);
+    assert(report1->srcInfoNodes.reserved == report1->srcInfoNodes.used);
+    assert(0 == report1->tmpBuf.reserved);
+
+    char buf[256];
+    TXN_printSL(space, root, buf, sizeof(buf), srcInfo);
+    assert(0 == strcmp("(a b c) [a \"b\" (d e f g)] h", buf));
+
+    TXN_spaceSrcInfoFree(srcInfo);
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static void shared_test(void)
+{
+    TXN_SharedPool* pool = TXN_sharedPoolNew();
+    static const char* vocab[] = { "def", "var", "if", "*", "x" };
+    for (u32 i = 0; i < 5; ++i)
+    {
+        u32 sym = TXN_sharedPoolAdd(pool, vocab[i], (u32)strlen(vocab[i]));
+        assert(i == sym);
+    }
+    u32 star = TXN_sharedPoolAdd(pool, "*", 1);
+    assert(3 == star);
+    TXN_sharedPoolFreeze(pool);
+    assert(5 == TXN_sharedPoolSymsTotal(pool));
+
+    const char* src0 = "(def sq (var x) (* x x)) (sq 7)";
+    const char* src1 = "(def cube (var x) (* x x x)) (cube 3)";
+    TXN_Space* space0 = TXN_spaceNewShared(pool);
+    TXN_Space* space1 = TXN_spaceNewShared(pool);
+    TXN_Space* space2 = TXN_spaceNew();
+    TXN_Node root0 = TXN_parseAsList(space0, src0, NULL);
+    TXN_Node root1 = TXN_parseAsList(space1, src1, NULL);
+    TXN_Node root2 = TXN_parseAsList(space2, src0, NULL);
+    assert(root0.id != TXN_Node_Invalid.id);
+    assert(root1.id != TXN_Node_Invalid.id);
+    assert(root2.id != TXN_Node_Invalid.id);
+
+    char buf[256];
+    TXN_printSL(space0, root0, buf, sizeof(buf), NULL);
+    assert(0 == strcmp(src0, buf));
+    TXN_printSL(space1, root1, buf, sizeof(buf), NULL);
+    assert(0 == strcmp(src1, buf));
+
+    TXN_SpaceMemReport report0[1];
+    TXN_SpaceMemReport report2[1];
+    TXN_spaceMemReport(space0, NULL, report0);
+    TXN_spaceMemReport(space2, NULL, report2);
+    assert(report0->pool.used < report2->pool.used);
+
+    const TXN_Node* def0 = TXN_seqElm(space0, TXN_seqElm(space0, root0)[0]);
+    const TXN_Node* def1 = TXN_seqElm(space1, TXN_seqElm(space1, root1)[0]);
+    const TXN_Node* def2 = TXN_seqElm(space2, TXN_seqElm(space2, root2)[0]);
+    assert(0 == strcmp("def", TXN_tokData(space0, def0[0])));
+    assert(TXN_viewTokData(TXN_spaceView(space0), def0[0]) == TXN_tokData(space0, def0[0]));
+    assert(TXN_tokData(space0, def0[0]) == TXN_tokData(space1, def1[0]));
+    assert(TXN_tokSymId(space0, def0[0]) == TXN_tokSymId(space1, def1[0]));
+    assert(TXN_tokEq(space0, def0[0], space1, def1[0]));
+    assert(TXN_tokEq(space0, def0[0], space2, def2[0]));
+    assert(!TXN_tokEq(space0, def0[1], space1, def1[1]));
+    assert(TXN_tokEq(space0, def0[1], space2, def2[1]));
+
+    u32 sym = TXN_tokSymId(space0, def0[1]);
+    assert(sym >= TXN_sharedPoolSymsTotal(pool));
+    assert(sym < TXN_spaceSymsTotal(space0));
+    assert(0 == strcmp("sq", TXN_symData(space0, sym)));
+    assert(0 == strcmp("var", TXN_symData(space0, 1)));
+
+    TXN_EvalProgram* prog = TXN_evalCompile(space0, root0, NULL);
+    assert(prog);
+    TXN_EvalVM* vm = TXN_evalVmNew(prog);
+    bool ok = TXN_evalRun(vm);
+    assert(ok);
+    assert(1 == TXN_evalStackTotal(vm));
+    assert(49 == TXN_evalStack(vm)[0].i);
+    TXN_evalVmFree(vm);
+    TXN_evalProgramFree(prog);
+
+    const char* paths[] = { "../1.txn", "../1.txn" };
+    TXN_Node roots[2];
+    TXN_ParallelOpt opt[1] = { 2 };
+    TXN_Space* space3 = TXN_spaceNewShared(pool);
+    u32 loaded = TXN_loadFiles(space3, paths, 2, roots, NULL, opt);
+    assert(2 == loaded);
+    u32 bufSize = 64 * 1024;
+    char* bufA = malloc(bufSize);
+    char* bufB = malloc(bufSize);
+    TXN_printSL(space3, roots[0], bufA, bufSize, NULL);
+    TXN_printSL(space3, roots[1], bufB, bufSize, NULL);
+    assert(0 == strcmp(bufA, bufB));
+    free(bufB);
+    free(bufA);
+    TXN_spaceFree(space3);
+
+    TXN_spaceFree(space2);
+    TXN_spaceFree(space1);
+    TXN_spaceFree(space0);
+    TXN_sharedPoolFree(pool);
+}
+
+
+
+
+
+
+
+static void prescan_test(void)
+{
+    const char* src = "(a b c) [a \"b c\" (d e f g)] // x\n {h} ()";
+    TXN_ParseCounts counts[1];
+    bool ok = TXN_parseCount(src, (u32)strlen(src), counts);
+    assert(ok);
+    assert(10 == counts->toks);
+    assert(5 == counts->seqs);
+    assert(2 == counts->maxDepth);
+    assert(7 == counts->maxOpenElms);
+    assert(3 == counts->maxTokLen);
+    ok = TXN_parseCount("(a b", 4, counts);
+    assert(!ok);
+    ok = TXN_parseCount("a b)", 4, counts);
+    assert(!ok);
+
+    TXN_Space* space0 = TXN_spaceNew();
+    TXN_Space* space1 = TXN_spaceNew();
+    TXN_spaceSetPrescan(space1, true);
+    TXN_SpaceSrcInfo srcInfo0[1] = { 0 };
+    TXN_SpaceSrcInfo srcInfo1[1] = { 0 };
+    TXN_Node root0 = TXN_parseAsList(space0, src, srcInfo0);
+    TXN_Node root1 = TXN_parseAsList(space1, src, srcInfo1);
+    assert(root0.id == root1.id);
+    assert(TXN_spaceNodesTotal(space0) == TXN_spaceNodesTotal(space1));
+
+    TXN_SpaceMemReport report[1];
+    TXN_spaceMemReport(space1, srcInfo1, report);
+    assert(report->nodes.reserved == report->nodes.used);
+    assert(report->srcInfoNodes.reserved == report->srcInfoNodes.used);
+
+    char buf0[256];
+    char buf1[256];
+    TXN_printSL(space0, root0, buf0, sizeof(buf0), srcInfo0);
+    TXN_printSL(space1, root1, buf1, sizeof(buf1), srcInfo1);
+    assert(0 == strcmp(buf0, buf1));
+
+    TXN_spaceSrcInfoFree(srcInfo1);
+    TXN_spaceSrcInfoFree(srcInfo0);
+    TXN_spaceFree(space1);
+    TXN_spaceFree(space0);
+}
+
+
+
+
+
+
+
+static void view_test(void)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, "(a \"b c\" [d]) e", NULL);
+
+    const TXN_SpaceView* view = TXN_spaceView(space);
+    assert(view->nodesTotal == TXN_spaceNodesTotal(space));
+    for (u32 i = 0; i < view->nodesTotal; ++i)
+    {
+        TXN_Node node = { i };
+        assert(TXN_viewNodeType(view, node) == TXN_nodeType(space, node));
+        if (TXN_nodeIsTok(space, node))
+        {
+            assert(TXN_viewTokSize(view, node) == TXN_tokSize(space, node));
+            assert(TXN_viewTokData(view, node) == TXN_tokData(space, node));
+            assert(TXN_viewTokQuoted(view, node) == TXN_tokQuoted(space, node));
+        }
+        else
+        {
+            assert(TXN_viewSeqLen(view, node) == TXN_seqLen(space, node));
+            assert(TXN_viewSeqElm(view, node) == TXN_seqElm(space, node));
+        }
+    }
+    assert(2 == TXN_viewSeqLen(view, root));
+
+    TXN_Node f = TXN_tokFromCstr(space, "f", false);
+    assert(view->nodesTotal == f.id + 1);
+    assert(0 == strcmp("f", TXN_viewTokData(view, f)));
+
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static void sym_test(void)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, "(a b a) [\"b\" c] a", NULL);
+    assert(root.id != TXN_Node_Invalid.id);
+    assert(3 == TXN_spaceSymsTotal(space));
+
+    u32 seen = 0;
+    for (u32 i = 0; i < TXN_spaceNodesTotal(space); ++i)
+    {
+        TXN_Node node = { i };
+        if (!TXN_nodeIsTok(space, node))
+        {
+            continue;
+        }
+        u32 sym = TXN_tokSymId(space, node);
+        assert(sym < TXN_spaceSymsTotal(space));
+        assert(sym <= seen);
+        seen += (sym == seen);
+        assert(TXN_symData(space, sym) == TXN_tokData(space, node));
+        assert(TXN_symSize(space, sym) == TXN_tokSize(space, node));
+    }
+    assert(3 == seen);
+
+    const TXN_Node* elms = TXN_seqElm(space, root);
+    const TXN_Node* round = TXN_seqElm(space, elms[0]);
+    const TXN_Node* square = TXN_seqElm(space, elms[1]);
+    assert(TXN_tokSymId(space, round[0]) == TXN_tokSymId(space, elms[2]));
+    assert(TXN_tokSymId(space, round[1]) == TXN_tokSymId(space, square[0]));
+    assert(TXN_tokSymId(space, round[0]) != TXN_tokSymId(space, square[1]));
+
+    TXN_Node d = TXN_tokFromCstr(space, "d", false);
+    assert(3 == TXN_tokSymId(space, d));
+    assert(0 == strcmp("d", TXN_symData(space, 3)));
+
+    TXN_SpaceMemReport report[1];
+    TXN_spaceMemReport(space, NULL, report);
+    assert(report->syms.used > 0);
+
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+typedef struct visit_test_ctx
+{
+    const TXN_Space* space;
+    u32 enters;
+    u32 leaves;
+    u32 maxDepth;
+} visit_test_ctx;
+
+static TXN_VisitAct visit_test_enter(void* ctx, TXN_Node node, u32 depth)
+{
+    visit_test_ctx* c = ctx;
+    ++c->enters;
+    c->maxDepth = (depth > c->maxDepth) ? depth : c->maxDepth;
+    if (TXN_nodeIsSeqSquare(c->space, node))
+    {
+        return TXN_VisitAct_Skip;
+    }
+    if (TXN_nodeIsTok(c->space, node) && (0 == strcmp("stop", TXN_tokData(c->space, node))))
+    {
+        return TXN_VisitAct_Stop;
+    }
+    return TXN_VisitAct_Enter;
+}
+
+static bool visit_test_leave(void* ctx, TXN_Node node, u32 depth)
+{
+    visit_test_ctx* c = ctx;
+    ++c->leaves;
+    return true;
+}
+
+static void visit_test_size(void* ctx, const TXN_Space* space, TXN_Node node, void* vals)
+{
+    u32* sizes = vals;
+    sizes[node.id] = 1;
+    if (TXN_nodeIsSeq(space, node))
+    {
+        for (u32 i = 0; i < TXN_seqLen(space, node); ++i)
+        {
+            sizes[node.id] += sizes[TXN_seqElm(space, node)[i].id];
+        }
+    }
+}
+
+static void visit_test(void)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, "(a (b c)) [d e] {f}", NULL);
+    TXN_Visitor* visitor = TXN_visitorNew();
+
+    visit_test_ctx ctx = { space };
+    bool done = TXN_visit(visitor, space, root, visit_test_enter, visit_test_leave, &ctx);
+    assert(done);
+    assert(9 == ctx.enters);
+    assert(8 == ctx.leaves);
+    assert(3 == ctx.maxDepth);
+
+    TXN_Node stop = TXN_parseAsList(space, "(a stop b) c", NULL);
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.space = space;
+    done = TXN_visit(visitor, space, stop, visit_test_enter, NULL, &ctx);
+    assert(!done);
+    assert(4 == ctx.enters);
+
+    u32 n = TXN_spaceNodesTotal(space);
+    u32* sizes = calloc(n, sizeof(u32));
+    u32* sizesAll = calloc(n, sizeof(u32));
+    TXN_fold(visitor, space, root, visit_test_size, NULL, sizes);
+    assert(11 == sizes[root.id]);
+    TXN_foldAll(space, visit_test_size, NULL, sizesAll);
+    assert(0 == memcmp(sizes, sizesAll, sizeof(u32) * (root.id + 1)));
+
+    TXN_Node a = TXN_tokFromCstr(space, "a", false);
+    TXN_Node pair[2] = { root, root };
+    TXN_Node shared = TXN_seqNew(space, TXN_NodeType_SeqRound, pair, 2);
+    TXN_Node triple[3] = { shared, a, shared };
+    TXN_Node top = TXN_seqNew(space, TXN_NodeType_SeqRound, triple, 3);
+    free(sizes);
+    sizes = calloc(TXN_spaceNodesTotal(space), sizeof(u32));
+    TXN_fold(visitor, space, top, visit_test_size, NULL, sizes);
+    assert(23 == sizes[shared.id]);
+    assert(48 == sizes[top.id]);
+
+    free(sizesAll);
+    free(sizes);
+    TXN_visitorFree(visitor);
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static void fold_parallel_test(void)
+{
+    const char* unit = "(a (b c) [d (e f)] {g}) ";
+    u32 unitLen = (u32)strlen(unit);
+    u32 units = 500;
+    char* src = malloc(unitLen * units + 1);
+    for (u32 i = 0; i < units; ++i)
+    {
+        memcpy(src + unitLen * i, unit, unitLen);
+    }
+    src[unitLen * units] = 0;
+
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, src, NULL);
+    u32 n = TXN_spaceNodesTotal(space);
+
+    TXN_Visitor* visitor = TXN_visitorNew();
+    u32* sizes = calloc(n, sizeof(u32));
+    TXN_fold(visitor, space, root, visit_test_size, NULL, sizes);
+    assert(n == sizes[root.id]);
+
+    TXN_ParallelOpt opts[] =
+    {
+        { 0, 0 },
+        { 4, 16 },
+        { 3, 1 },
+        { 1, 64 },
+    };
+    for (u32 i = 0; i < sizeof(opts) / sizeof(opts[0]); ++i)
+    {
+        u32* psizes = calloc(n, sizeof(u32));
+        TXN_foldParallel(space, root, visit_test_size, NULL, psizes, opts + i);
+        assert(0 == memcmp(sizes, psizes, sizeof(u32) * n));
+        free(psizes);
+    }
+
+    free(sizes);
+    TXN_visitorFree(visitor);
+    TXN_spaceFree(space);
+    free(src);
+}
+
+
+
+
+
+
+
+static void print_parallel_test(void)
+{
+    const char* unit = "(def f (x y) [\"a b\" {c d (e f g h i j k l m n o p q r s t u v w x y z)}]) tok ";
+    u32 unitLen = (u32)strlen(unit);
+    u32 units = 300;
+    char* src = malloc(unitLen * units + 1);
+    for (u32 i = 0; i < units; ++i)
+    {
+        memcpy(src + unitLen * i, unit, unitLen);
+    }
+    src[unitLen * units] = 0;
+    // the whole document inside one seq, split at nested seqs of each kind
+    char* wrapped = malloc(unitLen * units * 2 + 64);
+    sprintf(wrapped, "[x ((%s) {y %s} z) w]", src, src);
+
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node roots[] =
+    {
+        TXN_parseAsList(space, src, NULL),
+        TXN_parseAsList(space, "a (b c)", NULL),
+        TXN_parseAsList(space, "", NULL),
+        TXN_parseAsCell(space, "(a b)", NULL),
+        TXN_parseAsCell(space, wrapped, NULL),
+    };
+    TXN_ParallelOpt opts[] =
+    {
+        { 0, 0 },
+        { 4, 8 },
+        { 3, 1 },
+    };
+    TXN_PrintMlOpt mlOpt[1] = { 4, 50 };
+
+    u32 bufSize = unitLen * units * 4;
+    char* buf = malloc(bufSize);
+    char* pbuf = malloc(bufSize);
+    for (u32 r = 0; r < sizeof(roots) / sizeof(roots[0]); ++r)
+    {
+        for (u32 i = 0; i < sizeof(opts) / sizeof(opts[0]); ++i)
+        {
+            u32 n = TXN_printSL(space, roots[r], buf, bufSize, NULL);
+            u32 pn = TXN_printSlParallel(space, roots[r], pbuf, bufSize, NULL, opts + i);
+            assert(n == pn);
+            assert(0 == strcmp(buf, pbuf));
+
+            n = TXN_printML(space, roots[r], buf, bufSize, mlOpt);
+            pn = TXN_printMlParallel(space, roots[r], pbuf, bufSize, mlOpt, opts + i);
+            assert(n == pn);
+            assert(0 == strcmp(buf, pbuf));
+
+            n = TXN_printML(space, roots[r], buf, 100, mlOpt);
+            pn = TXN_printMlParallel(space, roots[r], pbuf, 100, mlOpt, opts + i);
+            assert(n == pn);
+            assert(0 == strcmp(buf, pbuf));
+        }
+    }
+
+    free(pbuf);
+    free(buf);
+    TXN_spaceFree(space);
+    free(wrapped);
+    free(src);
+}
+
+
+
+
+
+
+
+static void builder_test(void)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Builder* builder = TXN_builderNew(space);
+
+    TXN_builderSeqBegin(builder, TXN_NodeType_SeqNaked);
+    TXN_builderSeqBegin(builder, TXN_NodeType_SeqRound);
+    TXN_builderPushTok(builder, "def", 3, false);
+    TXN_builderPushTok(builder, "x", 1, false);
+    TXN_builderSeqBegin(builder, TXN_NodeType_SeqSquare);
+    TXN_builderPushTok(builder, "1", 1, false);
+    TXN_builderPushTok(builder, "2", 1, false);
+    TXN_builderPush(builder, TXN_builderSeqEnd(builder));
+    TXN_builderSeqBegin(builder, TXN_NodeType_SeqCurly);
+    TXN_builderPushTok(builder, "a b", 3, true);
+    TXN_builderSeqBegin(builder, TXN_NodeType_SeqRound);
+    TXN_builderPushTok(builder, "dropped", 7, false);
+    assert(4 == TXN_builderDepth(builder));
+    TXN_builderSeqCancel(builder);
+    TXN_builderPush(builder, TXN_builderSeqEnd(builder));
+    TXN_builderPush(builder, TXN_builderSeqEnd(builder));
+    TXN_builderPushTok(builder, "y", 1, false);
+    TXN_Node root = TXN_builderSeqEnd(builder);
+    assert(0 == TXN_builderDepth(builder));
+
+    char buf[256];
+    TXN_printSL(space, root, buf, sizeof(buf), NULL);
+    assert(0 == strcmp("(def x [1 2] {\"a\\ b\"}) y", buf));
+
+    TXN_Node parsed = TXN_parseAsList(space, buf, NULL);
+    char buf1[256];
+    TXN_printSL(space, parsed, buf1, sizeof(buf1), NULL);
+    assert(0 == strcmp(buf, buf1));
+
+    TXN_builderFree(builder);
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static void edit_test(void)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node v0 = TXN_parseAsList(space, "(a (b c) d) [e]", NULL);
+    u32 n0 = TXN_spaceNodesTotal(space);
+    char buf[256];
+
+    u32 path[] = { 0, 1, 1 };
+    TXN_Node v1 = TXN_editReplace(space, v0, path, 3, TXN_tokFromCstr(space, "x", false));
+    assert(TXN_spaceNodesTotal(space) == n0 + 4);
+    TXN_printSL(space, v1, buf, sizeof(buf), NULL);
+    assert(0 == strcmp("(a (b x) d) [e]", buf));
+    assert(TXN_seqElm(space, v1)[1].id == TXN_seqElm(space, v0)[1].id);
+    assert(TXN_seqElm(space, TXN_seqElm(space, v1)[0])[2].id == TXN_seqElm(space, TXN_seqElm(space, v0)[0])[2].id);
+
+    TXN_Node v2 = TXN_editInsert(space, v1, path, 2, TXN_tokFromCstr(space, "y", false));
+    TXN_printSL(space, v2, buf, sizeof(buf), NULL);
+    assert(0 == strcmp("(a y (b x) d) [e]", buf));
+
+    u32 tail[] = { 1, 1 };
+    TXN_Node v3 = TXN_editInsert(space, v2, tail, 2, TXN_tokFromCstr(space, "z", false));
+    TXN_printSL(space, v3, buf, sizeof(buf), NULL);
+    assert(0 == strcmp("(a y (b x) d) [e z]", buf));
+
+    TXN_Node v4 = TXN_editRemove(space, v3, path, 1);
+    TXN_printSL(space, v4, buf, sizeof(buf), NULL);
+    assert(0 == strcmp("[e z]", buf));
+
+    TXN_printSL(space, v0, buf, sizeof(buf), NULL);
+    assert(0 == strcmp("(a (b c) d) [e]", buf));
+
+    u32 bad[] = { 0, 0, 0 };
+    TXN_Node e0 = TXN_editRemove(space, v0, bad, 3);
+    TXN_Node e1 = TXN_editReplace(space, v0, tail, 2, v0);
+    TXN_Node e2 = TXN_editInsert(space, v0, tail, 2, v0);
+    assert(TXN_Node_Invalid.id == e0.id);
+    assert(TXN_Node_Invalid.id == e1.id);
+    assert(TXN_Node_Invalid.id != e2.id);
+
+    TXN_Node empty = TXN_parseAsList(space, "{}", NULL);
+    u32 first[] = { 0, 0 };
+    TXN_Node w1 = TXN_editInsert(space, empty, first, 2, TXN_tokFromCstr(space, "q", false));
+    TXN_printSL(space, w1, buf, sizeof(buf), NULL);
+    assert(0 == strcmp("{q}", buf));
+    TXN_Node w2 = TXN_editRemove(space, w1, first, 2);
+    TXN_printSL(space, w2, buf, sizeof(buf), NULL);
+    assert(0 == strcmp("{}", buf));
+
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static void load_test(void)
+{
+    char* text;
+    u32 textSize = FILEU_readFile("../1.txn", &text);
+    assert(textSize != -1);
+    TXN_Space* space0 = TXN_spaceNew();
+    TXN_SpaceSrcInfo srcInfo0[1] = { 0 };
+    TXN_Node root0 = TXN_parseAsList(space0, text, srcInfo0);
+    free(text);
+
+    const char* paths[] = { "../1.txn", "../missing.txn", "../1.txn", "../1.txn" };
+    u32 count = sizeof(paths) / sizeof(paths[0]);
+    TXN_Node roots[4];
+    TXN_ParallelOpt opt[1] = { 3 };
+    TXN_Space* space = TXN_spaceNew();
+    TXN_SpaceSrcInfo srcInfo[1] = { 0 };
+    u32 loaded = TXN_loadFiles(space, paths, count, roots, srcInfo, opt);
+    assert(3 == loaded);
+    assert(TXN_Node_Invalid.id == roots[1].id);
+    assert(count == srcInfo->fileBases->length);
+    assert(srcInfo->nodes->length == TXN_spaceNodesTotal(space));
+    assert(3 * TXN_spaceNodesTotal(space0) == TXN_spaceNodesTotal(space));
+
+    u32 bufSize = 64 * 1024;
+    char* buf0 = malloc(bufSize);
+    char* buf = malloc(bufSize);
+    TXN_PrintMlOpt mlOpt0[1] = { 4, 50, srcInfo0 };
+    TXN_PrintMlOpt mlOpt[1] = { 4, 50, srcInfo };
+    TXN_printML(space0, root0, buf0, bufSize, mlOpt0);
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (1 == i)
+        {
+            continue;
+        }
+        assert(srcInfo->fileBases->data[i] == roots[i].id + 1 - TXN_spaceNodesTotal(space0));
+        const TXN_NodeSrcInfo* info = TXN_nodeSrcInfo(srcInfo, roots[i]);
+        assert(i == info->file);
+        TXN_printML(space, roots[i], buf, bufSize, mlOpt);
+        assert(0 == strcmp(buf0, buf));
+    }
+    TXN_Node a = roots[0];
+    TXN_Node b = roots[3];
+    while (TXN_nodeIsSeq(space, a))
+    {
+        a = TXN_seqElm(space, a)[0];
+        b = TXN_seqElm(space, b)[0];
+    }
+    assert(a.id != b.id);
+    assert(TXN_tokData(space, a) == TXN_tokData(space, b));
+
+    free(buf);
+    free(buf0);
+    TXN_spaceSrcInfoFree(srcInfo);
+    TXN_spaceFree(space);
+    TXN_spaceSrcInfoFree(srcInfo0);
+    TXN_spaceFree(space0);
+}
+
+
+
+
+
+
+
+static void parse_file_test(void)
+{
+    char* text;
+    u32 textSize = FILEU_readFile("../1.txn", &text);
+    assert(textSize != -1);
+
+    TXN_Space* space = TXN_spaceNew();
+    TXN_SpaceSrcInfo srcInfo[1] = { 0 };
+    TXN_Node root0 = TXN_parseAsList(space, text, srcInfo);
+    TXN_Node root1 = TXN_parseFile(space, "../1.txn", srcInfo);
+    assert(root1.id != TXN_Node_Invalid.id);
+    assert(2 == srcInfo->fileBases->length);
+    assert(TXN_spaceNodesTotal(space) == (root0.id + 1) * 2);
+    assert(TXN_nodeSrcInfo(srcInfo, root1)->file == 1);
+    TXN_Node missing = TXN_parseFile(space, "../missing.txn", NULL);
+    assert(TXN_Node_Invalid.id == missing.id);
+    free(text);
+
+    u32 pageSize = 4096;
+    FILE* f = fopen("parse_file_test.txn", "wb");
+    assert(f);
+    for (u32 i = 0; i < pageSize / 4; ++i)
+    {
+        fwrite((i + 1 < pageSize / 4) ? "(a)\n" : "(ab)", 1, 4, f);
+    }
+    fclose(f);
+    TXN_Node page = TXN_parseFile(space, "parse_file_test.txn", NULL);
+    remove("parse_file_test.txn");
+    assert(TXN_seqLen(space, page) == pageSize / 4);
+
+    u32 bufSize = 64 * 1024;
+    char* buf0 = malloc(bufSize);
+    char* buf1 = malloc(bufSize);
+    TXN_printSL(space, root0, buf0, bufSize, NULL);
+    TXN_printSL(space, root1, buf1, bufSize, NULL);
+    assert(0 == strcmp(buf0, buf1));
+
+    free(buf1);
+    free(buf0);
+    TXN_spaceSrcInfoFree(srcInfo);
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+
+
+static bool bin_test_write(void* ctx, const void* data, u32 size)
+{
+    vec_char* out = ctx;
+    vec_pusharr(out, (const char*)data, size);
+    return true;
+}
+
+static bool bin_test_fail(void* ctx, const void* data, u32 size)
+{
+    return false;
+}
+
+static void bin_test(void)
+{
+    char* text;
+    u32 textSize = FILEU_readFile("../1.txn", &text);
+    assert(textSize != -1);
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, text, NULL);
+    free(text);
+
+    u32 bufSize = 64 * 1024;
+    char* buf0 = malloc(bufSize);
+    char* buf1 = malloc(bufSize);
+    TXN_printSL(space, root, buf0, bufSize, NULL);
+
+    u32 sizes[2];
+    for (u32 i = 0; i < 2; ++i)
+    {
+        TXN_BinOpt opt[1] = { 1 == i };
+        vec_char out[1] = { 0 };
+        u64 n = TXN_binEncode(space, root, opt, bin_test_write, out);
+        assert(n == out->length);
+        sizes[i] = out->length;
+
+        TXN_Space* space1 = TXN_spaceNew();
+        u32 consumed = 0;
+        TXN_Node root1 = TXN_binDecode(space1, out->data, out->length, &consumed);
+        assert(root1.id != TXN_Node_Invalid.id);
+        assert(consumed == out->length);
+        TXN_printSL(space1, root1, buf1, bufSize, NULL);
+        assert(0 == strcmp(buf0, buf1));
+
+        TXN_Node cut = TXN_binDecode(space1, out->data, out->length - 1, NULL);
+        TXN_Node shifted = TXN_binDecode(space1, out->data + 1, out->length - 1, NULL);
+        assert(TXN_Node_Invalid.id == cut.id);
+        assert(TXN_Node_Invalid.id == shifted.id);
+
+        TXN_spaceFree(space1);
+        vec_free(out);
+    }
+    assert(sizes[1] < sizes[0]);
+    assert(sizes[0] < strlen(buf0));
+    u64 failed = TXN_binEncode(space, root, NULL, bin_test_fail, NULL);
+    assert(0 == failed);
+
+    TXN_Node tok = TXN_tokFromCstr(space, "a b", true);
+    vec_char out[1] = { 0 };
+    TXN_binEncode(space, tok, NULL, bin_test_write, out);
+    TXN_Node tok1 = TXN_binDecode(space, out->data, out->length, NULL);
+    assert(TXN_tokQuoted(space, tok1));
+    assert(TXN_nodeDataEq(space, tok, tok1));
+    vec_free(out);
+
+    free(buf1);
+    free(buf0);
+    TXN_spaceFree(space);
+}
+
+
+
+
+
+static TXN_EvalVM* eval_test_run(TXN_Space* space, const char* src, TXN_EvalProgram** pProg)
+{
+    TXN_Node root = TXN_parseAsList(space, src, NULL);
+    TXN_EvalErrInfo err;
+    TXN_EvalProgram* prog = TXN_evalCompile(space, root, &err);
+    assert(prog);
+    assert(TXN_EvalErr_None == err.err);
+    TXN_EvalVM* vm = TXN_evalVmNew(prog);
+    *pProg = prog;
+    return vm;
+}
+
+
+static void eval_test(void)
+{
+    char* text;
+    u32 textSize = FILEU_readFile("../1.txn", &text);
+    assert(textSize != -1);
+    TXN_Space* space = TXN_spaceNew();
+    TXN_EvalProgram* prog;
+    TXN_EvalVM* vm = eval_test_run(space, text, &prog);
+    free(text);
+
+    // 50000 2 tailtest divides ints, n / res reaches a zero res a few tail calls in
+    for (u32 r = 0; r < 2; ++r)
+    {
+        TXN_evalStackClear(vm);
+        bool ok = TXN_evalRun(vm);
+        assert(!ok);
+        assert(TXN_EvalErr_DivZero == TXN_evalVmErr(vm).err);
+        assert(0 == strcmp(TXN_tokData(space, TXN_evalVmErr(vm).node), "/"));
+        static const s64 ints[] = { 3, 2, 200, -1, 6765, 6765 };
+        u32 n = sizeof(ints) / sizeof(ints[0]);
+        assert(TXN_evalStackTotal(vm) >= n);
+        const TXN_EvalVal* stack = TXN_evalStack(vm);
+        for (u32 i = 0; i < n; ++i)
+        {
+            if (ints[i] < 0)
+            {
+                assert(TXN_EvalValType_Str == stack[i].type);
+                assert(0 == strcmp(TXN_tokData(space, stack[i].str), "b"));
+                continue;
+            }
+            assert(TXN_EvalValType_Int == stack[i].type);
+            assert(ints[i] == stack[i].i);
+        }
+    }
+    TXN_evalVmFree(vm);
+    TXN_evalProgramFree(prog);
+
+    vm = eval_test_run(space, "(/ 7 2) (/ 7.0 2) (% 7 2) (lt 1 1.5) (eq \"x\" \"x\") [1 2] !", &prog);
+    bool ok = TXN_evalRun(vm);
+    assert(ok);
+    const TXN_EvalVal* stack = TXN_evalStack(vm);
+    assert(7 == TXN_evalStackTotal(vm));
+    assert((TXN_EvalValType_Int == stack[0].type) && (3 == stack[0].i));
+    assert((TXN_EvalValType_Float == stack[1].type) && (3.5 == stack[1].f));
+    assert(1 == stack[2].i);
+    assert(1 == stack[3].i);
+    assert(1 == stack[4].i);
+    assert((1 == stack[5].i) && (2 == stack[6].i));
+    TXN_evalVmFree(vm);
+    TXN_evalProgramFree(prog);
+
+    vm = eval_test_run
+    (
+        space,
+        "(def loop (var n acc) (if (eq n 0) acc (loop (- n 1) (+ acc 1))))"
+        "(def deep (var n) (if (eq n 0) 0 (+ 1 (deep (- n 1)))))"
+        "(def even (var n) (if (eq n 0) 1 (odd (- n 1))))"
+        "(def odd (var n) (if (eq n 0) 0 (even (- n 1))))"
+        "(loop 1000000 0) (deep 200000) (even 100001) (if 1 { 7 0 [loop] ! } 0)",
+        &prog
+    );
+    TXN_evalStackClear(vm);
+    ok = TXN_evalRun(vm);
+    assert(ok);
+    stack = TXN_evalStack(vm);
+    assert(4 == TXN_evalStackTotal(vm));
+    assert(1000000 == stack[0].i);
+    assert(200000 == stack[1].i);
+    assert(0 == stack[2].i);
+    assert(7 == stack[3].i);
+    TXN_evalVmFree(vm);
+    TXN_evalProgramFree(prog);
+
+    vm = eval_test_run
+    (
+        space,
+        "(& 1000) [3 *] map (var a) (& 1000) [3 * 0 +] map (var b) "
+        "a [1000 gt] filter size b [1000 gt 0 +] filter size "
+        "a [+] reduce b [+ 0 +] reduce "
+        "a [0.5 *] map [+] reduce b [0.5 * 0 +] map [+ 0 +] reduce "
+        "(& 10) [2.5 lt] filter size (&> (map (& 10) [2.0 /]) 3) "
+        "(&< a 0 1.5) (&> a 0) (&> a 1) (&< a 2 \"s\") (&> a 1)",
+        &prog
+    );
+    ok = TXN_evalRun(vm);
+    assert(ok);
+    stack = TXN_evalStack(vm);
+    assert(11 == TXN_evalStackTotal(vm));
+    assert((666 == stack[0].i) && (666 == stack[1].i));
+    assert((1498500 == stack[2].i) && (1498500 == stack[3].i));
+    assert((TXN_EvalValType_Float == stack[4].type) && (749250.0 == stack[4].f) && (749250.0 == stack[5].f));
+    assert(3 == stack[6].i);
+    assert((TXN_EvalValType_Float == stack[7].type) && (1.5 == stack[7].f));
+    assert(1.5 == stack[8].f);
+    assert((TXN_EvalValType_Float == stack[9].type) && (3.0 == stack[9].f));
+    assert((TXN_EvalValType_Float == stack[10].type) && (3.0 == stack[10].f));
+    TXN_evalVmFree(vm);
+    TXN_evalProgramFree(prog);
+
+    vm = eval_test_run
+    (
+        space,
+        "(def drop (var x)) (& 1000) [1 +] map (var keep) (& 100000) [2 *] map [+] reduce "
+        "(& 2) (var box) (&< box 0 (& 5)) (&< box 1 \"x\") (& 100000) drop gc (&> (&> box 0) 4) "
+        "(& 3) [gc 1 +] map size keep",
+        &prog
+    );
+    ok = TXN_evalRun(vm);
+    assert(ok);
+    assert(4 == TXN_evalStackTotal(vm));
+    assert(TXN_evalHeapSize(vm) < 100000 * sizeof(s64));
+    TXN_evalGc(vm);
+    stack = TXN_evalStack(vm);
+    assert(9999900000 == stack[0].i);
+    assert(4 == stack[1].i);
+    assert(3 == stack[2].i);
+    assert(1000 == TXN_evalAryLen(vm, stack[3]));
+    assert(1000 == TXN_evalAryElm(vm, stack[3], 999).i);
+    TXN_evalStackClear(vm);
+    TXN_evalGc(vm);
+    assert(TXN_evalHeapSize(vm) > 0);
+    TXN_evalVmFree(vm);
+    TXN_evalProgramFree(prog);
+
+    vm = eval_test_run
+    (
+        space,
+        "(& 5000) [(var x) (& 2)] map (var m) (size m) (size (&> m 4999)) "
+        "(& 6) [(var x) (if (lt x 2) x (if (lt x 4) 0.5 \"s\"))] map (var s) "
+        "(&> s 1) (&> s 3) (&> s 5) (& 1) (&> m 0)",
+        &prog
+    );
+    ok = TXN_evalRun(vm);
+    assert(ok);
+    stack = TXN_evalStack(vm);
+    assert(7 == TXN_evalStackTotal(vm));
+    assert((5000 == stack[0].i) && (2 == stack[1].i));
+    assert((TXN_EvalValType_Float == stack[2].type) && (1.0 == stack[2].f));
+    assert((TXN_EvalValType_Float == stack[3].type) && (0.5 == stack[3].f));
+    assert(TXN_EvalValType_Str == stack[4].type);
+    assert(1 == TXN_evalAryLen(vm, stack[5]));
+    assert(2 == TXN_evalAryLen(vm, stack[6]));
+    TXN_evalVmFree(vm);
+    TXN_evalProgramFree(prog);
+
+    static const struct { const char* src; TXN_EvalErr err; } fails[] =
+    {
+        { "1 0 /", TXN_EvalErr_DivZero },
+        { "1 0 %", TXN_EvalErr_DivZero },
+        { "(def t (var n) (if (eq n 0) (/ 1 n) (t (- n 1)))) (t 1000000)", TXN_EvalErr_DivZero },
+        { "1 +", TXN_EvalErr_StackUnderflow },
+        { "\"a\" 1 lt", TXN_EvalErr_Type },
+        { "(&> (& 3) 3)", TXN_EvalErr_Index },
+        { "1 !", TXN_EvalErr_Type },
+    };
+    for (u32 i = 0; i < sizeof(fails) / sizeof(fails[0]); ++i)
+    {
+        vm = eval_test_run(space, fails[i].src, &prog);
+        ok = TXN_evalRun(vm);
+        assert(!ok);
+        assert(fails[i].err == TXN_evalVmErr(vm).err);
+        assert(TXN_nodeIsTok(space, TXN_evalVmErr(vm).node));
+        TXN_evalVmFree(vm);
+        TXN_evalProgramFree(prog);
+    }
+
+    TXN_Space* empty = TXN_spaceNew();
+    TXN_Node emptyRoot = TXN_parseAsList(empty, "", NULL);
+    prog = TXN_evalCompile(empty, emptyRoot, NULL);
+    vm = TXN_evalVmNew(prog);
+    ok = TXN_evalRun(vm);
+    assert(ok);
+    assert(0 == TXN_evalStackTotal(vm));
+    TXN_evalVmFree(vm);
+    TXN_evalProgramFree(prog);
+    TXN_spaceFree(empty);
+
+    TXN_EvalErrInfo err;
+    TXN_Node root = TXN_parseAsList(space, "1 2 foo", NULL);
+    prog = TXN_evalCompile(space, root, &err);
+    assert(!prog);
+    assert(TXN_EvalErr_Unbound == err.err);
+    assert(0 == strcmp(TXN_tokData(space, err.node), "foo"));
+    root = TXN_parseAsList(space, "(def f 1) (def f 2)", NULL);
+    prog = TXN_evalCompile(space, root, &err);
+    assert(!prog);
+    assert(TXN_EvalErr_Syntax == err.err);
+
+    u32 deep = 200000;
+    char* src = malloc(deep * 2 + 2);
+    memset(src, '(', deep);
+    src[deep] = '1';
+    memset(src + deep + 1, ')', deep);
+    src[deep * 2 + 1] = 0;
+    root = TXN_parseAsList(space, src, NULL);
+    free(src);
+    assert(root.id != TXN_Node_Invalid.id);
+    prog = TXN_evalCompile(space, root, &err);
+    assert(!prog);
+    assert(TXN_EvalErr_Syntax == err.err);
+
+    TXN_spaceFree(space);
+}
+
+
 int main(int argc, char* argv[])
 {
 #if !defined(NDEBUG) && defined(_WIN32)
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
     pp_test();
+    query_test();
+    classify_test();
+    str_test();
+    stats_test();
+    mem_test();
+    prescan_test();
+    shared_test();
+    view_test();
+    sym_test();
+    visit_test();
+    fold_parallel_test();
+    print_parallel_test();
+    builder_test();
+    edit_test();
+    load_test();
+    parse_file_test();
+    bin_test();
+    eval_test();
     return mainReturn(EXIT_SUCCESS);
 }
 
@@ -0,0 +1,77 @@
+#include "txn.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+
+
+
+static void hpp_test(void)
+{
+    txn::Space space;
+    txn::Node root = space.parseAsList("(add 1 2.5) [\"a b\" c] {}");
+    assert(root);
+    assert(root.isSeqNaked());
+
+    txn::Seq list = root.seq();
+    assert(3 == list.size());
+
+    txn::Node add = list.at(0);
+    assert(add.isSeqRound());
+    assert(3 == add.seq().size());
+    assert("add" == add.seq().at(0).tok());
+    assert(!add.seq().at(0).quoted());
+
+    space.classifyToks();
+    assert(TXN_TokClass_Int == add.seq().at(1).tokClass());
+    assert(1 == add.seq().at(1).asI64());
+    assert(2.5 == add.seq().at(2).asF64());
+
+    txn::Node sq = list.at(1);
+    assert(sq.isSeqSquare());
+    assert("a b" == sq.seq().at(0).tok());
+    assert(sq.seq().at(0).quoted());
+
+    assert(list.at(2).isSeqCurly());
+    assert(list.at(2).seq().empty());
+
+    std::string all;
+    for (TXN_Node elm : add.seq())
+    {
+        all += space.node(elm).tok();
+    }
+    assert("add12.5" == all);
+
+    txn::Node c = space.tok("c");
+    assert(c.dataEq(sq.seq().at(1)));
+    assert(c != sq.seq().at(1));
+
+    TXN_Node elms[] = { c.raw(), c.raw() };
+    txn::Node cc = space.seq(TXN_NodeType_SeqRound, elms, 2);
+    char buf[64];
+    TXN_printSL(space.get(), cc.raw(), buf, sizeof(buf), NULL);
+    assert(0 == strcmp("(c c)", buf));
+
+    txn::Space moved = static_cast<txn::Space&&>(space);
+    assert(!space.get());
+    assert(moved.nodesTotal() > 0);
+
+    txn::Space other;
+    other.tok("d");
+    other = static_cast<txn::Space&&>(moved);
+    assert(!moved.get());
+    assert(other.nodesTotal() > 1);
+}
+
+
+
+
+
+
+
+int main(int argc, char* argv[])
+{
+    hpp_test();
+    return 0;
+}
@@ -14,6 +14,11 @@ TXN_Space* TXN_spaceNew(void)
 
 void TXN_spaceFree(TXN_Space* space)
 {
+    TXN_idMapFree(space->symMap);
+    vec_free(space->syms);
+    vec_free(space->tokSyms);
+    vec_free(space->tokNums);
+    vec_free(space->tokClasses);
     vec_free(space->tmpBuf);
     upool_free(space->dataPool);
     vec_free(space->nodes);
@@ -40,6 +45,98 @@ const TXN_NodeSrcInfo* TXN_nodeSrcInfo(const TXN_SpaceSrcInfo* srcInfo, TXN_Node
 
 
 
+#define TXN_vecMemUsage(v) { (u64)(v)->length * sizeof(*(v)->data), (u64)(v)->capacity * sizeof(*(v)->data) }
+
+static void TXN_memUsageAdd(TXN_MemUsage* a, const TXN_MemUsage* b)
+{
+    a->used += b->used;
+    a->reserved += b->reserved;
+}
+
+
+void TXN_spaceMemReport(const TXN_Space* space, const TXN_SpaceSrcInfo* srcInfo, TXN_SpaceMemReport* out)
+{
+    memset(out, 0, sizeof(*out));
+    TXN_MemUsage nodes = TXN_vecMemUsage(space->nodes);
+    TXN_MemUsage tmpBuf = TXN_vecMemUsage(space->tmpBuf);
+    TXN_MemUsage tokClasses = TXN_vecMemUsage(space->tokClasses);
+    TXN_MemUsage tokNums = TXN_vecMemUsage(space->tokNums);
+    TXN_MemUsage tokSyms = TXN_vecMemUsage(space->tokSyms);
+    TXN_MemUsage syms = TXN_vecMemUsage(space->syms);
+    TXN_MemUsage symMap = TXN_vecMemUsage(space->symMap->slots);
+    out->nodes = nodes;
+    out->pool.used = space->poolBytes;
+    out->pool.reserved = space->poolBytes;
+    out->poolElms = space->poolElms;
+    out->tmpBuf = tmpBuf;
+    out->tokClasses = tokClasses;
+    TXN_memUsageAdd(&out->tokClasses, &tokNums);
+    out->syms = tokSyms;
+    TXN_memUsageAdd(&out->syms, &syms);
+    TXN_memUsageAdd(&out->syms, &symMap);
+    if (srcInfo)
+    {
+        TXN_MemUsage srcInfoNodes = TXN_vecMemUsage(srcInfo->nodes);
+        TXN_MemUsage srcInfoFileBases = TXN_vecMemUsage(srcInfo->fileBases);
+        out->srcInfoNodes = srcInfoNodes;
+        out->srcInfoFileBases = srcInfoFileBases;
+    }
+    TXN_memUsageAdd(&out->total, &out->nodes);
+    TXN_memUsageAdd(&out->total, &out->pool);
+    TXN_memUsageAdd(&out->total, &out->tmpBuf);
+    TXN_memUsageAdd(&out->total, &out->tokClasses);
+    TXN_memUsageAdd(&out->total, &out->syms);
+    TXN_memUsageAdd(&out->total, &out->srcInfoNodes);
+    TXN_memUsageAdd(&out->total, &out->srcInfoFileBases);
+}
+
+
+void TXN_spaceShrinkToFit(TXN_Space* space, TXN_SpaceSrcInfo* srcInfo)
+{
+    vec_compact(space->nodes);
+    TXN_spaceViewSync(space);
+    vec_free(space->tmpBuf);
+    vec_compact(space->tokClasses);
+    vec_compact(space->tokNums);
+    vec_compact(space->tokSyms);
+    vec_compact(space->syms);
+    if (srcInfo)
+    {
+        vec_compact(srcInfo->nodes);
+        vec_compact(srcInfo->fileBases);
+    }
+}
+
+
+
+void TXN_spaceReserve(TXN_Space* space, TXN_SpaceSrcInfo* srcInfo, const TXN_ParseCounts* counts)
+{
+    // the naked list of a list parse is the one node without a token in the text
+    u32 nodes = counts->toks + counts->seqs + 1;
+    vec_reserve(space->nodes, space->nodes->length + nodes);
+    vec_reserve(space->tokSyms, space->tokSyms->length + nodes);
+    TXN_spaceViewSync(space);
+    vec_reserve(space->tmpBuf, counts->maxTokLen + 1);
+    if (!space->poolElms)
+    {
+        upool_free(space->dataPool);
+        space->dataPool = upool_new((u32)max(256, min(counts->payloadBytes, (u64)UINT32_MAX)));
+    }
+    if (srcInfo)
+    {
+        vec_reserve(srcInfo->nodes, srcInfo->nodes->length + nodes);
+    }
+}
+
+void TXN_spaceSetPrescan(TXN_Space* space, bool on)
+{
+    space->prescan = on;
+}
+
+
+
+
+
 
 u32 TXN_spaceNodesTotal(const TXN_Space* space)
 {
@@ -49,6 +146,27 @@ u32 TXN_spaceNodesTotal(const TXN_Space* space)
 
 
 
+bool TXN_spaceStats(const TXN_Space* space, TXN_Stats* out)
+{
+#ifdef TXN_STATS
+    *out = *space->stats;
+    return true;
+#else
+    memset(out, 0, sizeof(*out));
+    return false;
+#endif
+}
+
+void TXN_spaceStatsReset(TXN_Space* space)
+{
+#ifdef TXN_STATS
+    memset(space->stats, 0, sizeof(space->stats));
+#endif
+}
+
+
+
+
 
 
 
@@ -67,26 +185,114 @@ TXN_NodeType TXN_nodeType(const TXN_Space* space, TXN_Node node)
 
 
 
-TXN_Node TXN_tokFromCstr(TXN_Space* space, const char* str, bool quoted)
+u32 TXN_poolElm(TXN_Space* space, const void* data, u32 size)
+{
+    TXN_STAT(u64 t0 = TXN_statsNow());
+    bool isNew;
+    u32 offset = upool_elm(space->dataPool, data, size, &isNew);
+    if (isNew)
+    {
+        space->poolBytes += size;
+        ++space->poolElms;
+        space->view->poolBase = (const char*)upool_elmData(space->dataPool, offset) - offset;
+    }
+    TXN_STAT(++*(isNew ? &space->stats->poolInserts : &space->stats->poolHits));
+    TXN_STAT(space->stats->cycles[TXN_StatsPhase_Intern] += TXN_statsNow() - t0);
+    return offset;
+}
+
+
+// a payload first pooled as seq elements can come back as a token, so symbols are keyed on the offset
+static u32 TXN_poolTok(TXN_Space* space, const void* data, u32 len, u32* sym)
+{
+    if (space->shared)
+    {
+        u32 shared = TXN_sharedPoolFind(space->shared, data, len);
+        if (shared != (u32)-1)
+        {
+            TXN_STAT(++space->stats->poolHits);
+            *sym = shared;
+            return space->shared->syms->data[shared].offset | TXN_SharedDataBit;
+        }
+    }
+    u32 offset = TXN_poolElm(space, data, len + 1);
+    if (space->shared && (offset & TXN_SharedDataBit))
+    {
+        // the token would be read from the shared pool, there is no error path here so stop instead
+        fprintf(stderr, "TXN: own pool of a space attached to a shared pool is over %u bytes\n", TXN_SharedDataBit);
+        abort();
+    }
+    bool isNew;
+    *sym = TXN_spaceSharedSyms(space) + *TXN_idMapPut(space->symMap, offset, space->syms->length, &isNew);
+    if (isNew)
+    {
+        TXN_SymInfo info = { offset, len };
+        TXN_vecPush(space, space->syms, info);
+    }
+    return offset;
+}
+
+
+
+static TXN_Node TXN_nodeAdd(TXN_Space* space, const TXN_NodeInfo* info, u32 sym)
 {
-    u32 len = (u32)strlen(str);
-    u32 offset = upool_elm(space->dataPool, str, len + 1, NULL);
-    TXN_NodeInfo info = { TXN_NodeType_Tok, offset, len, quoted };
     TXN_Node node = { space->nodes->length };
-    vec_push(space->nodes, info);
+    TXN_vecPush(space, space->nodes, *info);
+    TXN_vecPush(space, space->tokSyms, sym);
+    TXN_spaceViewSync(space);
     return node;
 }
 
+
+
+static const bool TXN_NeedQuoteTable[256] =
+{
+    ['('] = true, [')'] = true, ['['] = true, [']'] = true, ['{'] = true, ['}'] = true,
+    ['"'] = true, ['\''] = true, [' '] = true, ['\t'] = true, ['\n'] = true, ['\r'] = true,
+    ['\b'] = true, ['\f'] = true,
+};
+
+u32 TXN_tokFlags(const char* str, u32 len, bool quoted)
+{
+    u32 flags = quoted ? TXN_NodeFlag_Quoted : 0;
+    for (u32 i = 0; i < len; ++i)
+    {
+        if (TXN_NeedQuoteTable[(u8)str[i]])
+        {
+            flags |= TXN_NodeFlag_NeedQuote;
+            break;
+        }
+    }
+    return flags;
+}
+
+
+
+TXN_Node TXN_tokFromCstr(TXN_Space* space, const char* str, bool quoted)
+{
+    u32 len = (u32)strlen(str);
+    u32 sym;
+    u32 offset = TXN_poolTok(space, str, len, &sym);
+    TXN_NodeInfo info = { TXN_NodeType_Tok, offset, len, TXN_tokFlags(str, len, quoted) };
+    return TXN_nodeAdd(space, &info, sym);
+}
+
 TXN_Node TXN_tokFromBuf(TXN_Space* space, const char* ptr, u32 len, bool quoted)
 {
     vec_resize(space->tmpBuf, len + 1);
     memcpy(space->tmpBuf->data, ptr, len);
     space->tmpBuf->data[len] = 0;
-    u32 offset = upool_elm(space->dataPool, space->tmpBuf->data, len + 1, NULL);
-    TXN_NodeInfo info = { TXN_NodeType_Tok, offset, len, quoted };
-    TXN_Node node = { space->nodes->length };
-    vec_push(space->nodes, info);
-    return node;
+    return TXN_tokFromTmpBuf(space, len, TXN_tokFlags(ptr, len, quoted));
+}
+
+TXN_Node TXN_tokFromTmpBuf(TXN_Space* space, u32 len, u32 flags)
+{
+    assert(space->tmpBuf->length > len);
+    assert(!space->tmpBuf->data[len]);
+    u32 sym;
+    u32 offset = TXN_poolTok(space, space->tmpBuf->data, len, &sym);
+    TXN_NodeInfo info = { TXN_NodeType_Tok, offset, len, flags };
+    return TXN_nodeAdd(space, &info, sym);
 }
 
 
@@ -95,13 +301,51 @@ TXN_Node TXN_tokFromBuf(TXN_Space* space, const char* ptr, u32 len, bool quoted)
 
 
 
+u32 TXN_spaceImport(TXN_Space* space, const TXN_Space* src, u32 begin, u32 end)
+{
+    u32 base = space->nodes->length;
+    TXN_NodeVec elms[1] = { 0 };
+    for (u32 i = begin; i < end; ++i)
+    {
+        const TXN_NodeInfo* srcInfo = src->nodes->data + i;
+        TXN_NodeInfo info = *srcInfo;
+        u32 sym = (u32)-1;
+        if (TXN_NodeType_Tok == info.type)
+        {
+            info.offset = TXN_poolTok(space, TXN_tokDataAt(src, info.offset), info.length, &sym);
+        }
+        else
+        {
+            const void* data = upool_elmData(src->dataPool, srcInfo->offset);
+            vec_resize(elms, info.length);
+            for (u32 j = 0; j < info.length; ++j)
+            {
+                TXN_Node e = ((const TXN_Node*)data)[j];
+                assert((begin <= e.id) && (e.id < i));
+                elms->data[j].id = e.id - begin + base;
+            }
+            info.offset = TXN_poolElm(space, elms->data, sizeof(TXN_Node)*info.length);
+        }
+        TXN_nodeAdd(space, &info, sym);
+    }
+    vec_free(elms);
+    return base;
+}
+
+
+
+
 TXN_Node TXN_seqNew(TXN_Space* space, TXN_NodeType type, const TXN_Node* elms, u32 len)
 {
-    u32 offset = upool_elm(space->dataPool, elms, sizeof(TXN_Node)*len, NULL);
+    // an empty builder stack has no buffer yet, but the pool still wants a valid pointer
+    static const TXN_Node noElms[1];
+    if (!len)
+    {
+        elms = noElms;
+    }
+    u32 offset = TXN_poolElm(space, elms, sizeof(TXN_Node)*len);
     TXN_NodeInfo nodeInfo = { type, offset, len };
-    TXN_Node node = { space->nodes->length };
-    vec_push(space->nodes, nodeInfo);
-    return node;
+    return TXN_nodeAdd(space, &nodeInfo, (u32)-1);
 }
 
 
@@ -130,14 +374,49 @@ const char* TXN_tokData(const TXN_Space* space, TXN_Node node)
 {
     TXN_NodeInfo* info = space->nodes->data + node.id;
     assert(TXN_NodeType_Tok == info->type);
-    return upool_elmData(space->dataPool, info->offset);
+    return TXN_tokDataAt(space, info->offset);
+}
+
+
+
+u32 TXN_tokSymId(const TXN_Space* space, TXN_Node node)
+{
+    assert(TXN_NodeType_Tok == space->nodes->data[node.id].type);
+    return space->tokSyms->data[node.id];
+}
+
+u32 TXN_spaceSymsTotal(const TXN_Space* space)
+{
+    return TXN_spaceSharedSyms(space) + space->syms->length;
+}
+
+u32 TXN_symSize(const TXN_Space* space, u32 sym)
+{
+    assert(sym < TXN_spaceSymsTotal(space));
+    u32 shared = TXN_spaceSharedSyms(space);
+    if (sym < shared)
+    {
+        return space->shared->syms->data[sym].length;
+    }
+    return space->syms->data[sym - shared].length;
+}
+
+const char* TXN_symData(const TXN_Space* space, u32 sym)
+{
+    assert(sym < TXN_spaceSymsTotal(space));
+    u32 shared = TXN_spaceSharedSyms(space);
+    if (sym < shared)
+    {
+        return space->shared->data->data + space->shared->syms->data[sym].offset;
+    }
+    return upool_elmData(space->dataPool, space->syms->data[sym - shared].offset);
 }
 
 bool TXN_tokQuoted(const TXN_Space* space, TXN_Node node)
 {
     TXN_NodeInfo* info = space->nodes->data + node.id;
     assert(TXN_NodeType_Tok == info->type);
-    return info->quoted;
+    return (info->flags & TXN_NodeFlag_Quoted) != 0;
 }
 
 
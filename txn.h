@@ -6,6 +6,11 @@
 #include <stdint.h>
 #include <assert.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
 #include <vec.h>
 
 
@@ -58,9 +63,72 @@ TXN_Space* TXN_spaceNew(void);
 void TXN_spaceFree(TXN_Space* space);
 
 
+// a token vocabulary for many spaces. it is filled once and frozen, after that any number of threads
+// can attach spaces and look tokens up in it without locking. it must outlive the spaces attached to it
+typedef struct TXN_SharedPool TXN_SharedPool;
+
+TXN_SharedPool* TXN_sharedPoolNew(void);
+void TXN_sharedPoolFree(TXN_SharedPool* pool);
+u32 TXN_sharedPoolAdd(TXN_SharedPool* pool, const char* ptr, u32 len);
+void TXN_sharedPoolFreeze(TXN_SharedPool* pool);
+u32 TXN_sharedPoolSymsTotal(const TXN_SharedPool* pool);
+
+// tokens found in pool are stored there once, the rest go to the space's own pool.
+// own token offsets of such a space must stay below TXN_SharedDataBit (2 GB), a token past it aborts
+TXN_Space* TXN_spaceNewShared(const TXN_SharedPool* pool);
+
+
 u32 TXN_spaceNodesTotal(const TXN_Space* space);
 
 
+
+typedef enum TXN_StatsPhase
+{
+    TXN_StatsPhase_Parse,
+    TXN_StatsPhase_Skip,
+    TXN_StatsPhase_Unescape,
+    TXN_StatsPhase_Intern,
+    TXN_StatsPhase_SrcInfo,
+    TXN_StatsPhase_PrintSL,
+    TXN_StatsPhase_PrintML,
+
+    TXN_NumStatsPhases
+} TXN_StatsPhase;
+
+static const char* TXN_StatsPhaseNameTable(TXN_StatsPhase p)
+{
+    assert(p < TXN_NumStatsPhases);
+    static const char* a[TXN_NumStatsPhases] =
+    {
+        "Parse",
+        "Skip",
+        "Unescape",
+        "Intern",
+        "SrcInfo",
+        "PrintSL",
+        "PrintML",
+    };
+    return a[p];
+}
+
+typedef struct TXN_Stats
+{
+    u64 textToks;
+    u64 stringToks;
+    u64 seqToks;
+    u64 spaceBytes;
+    u64 commentBytes;
+    u64 poolHits;
+    u64 poolInserts;
+    u64 vecGrows;
+    u32 maxDepth;
+    u64 cycles[TXN_NumStatsPhases];
+} TXN_Stats;
+
+bool TXN_spaceStats(const TXN_Space* space, TXN_Stats* out);
+void TXN_spaceStatsReset(TXN_Space* space);
+
+
 typedef struct TXN_Node { u32 id; } TXN_Node;
 typedef vec_t(TXN_Node) TXN_NodeVec;
 
@@ -69,6 +137,86 @@ static TXN_Node TXN_Node_Invalid = { (u32)-1 };
 
 TXN_NodeType TXN_nodeType(const TXN_Space* space, TXN_Node node);
 
+
+
+
+typedef enum TXN_NodeFlag
+{
+    TXN_NodeFlag_Quoted = 1 << 0,
+    TXN_NodeFlag_NeedQuote = 1 << 1,
+} TXN_NodeFlag;
+
+typedef struct TXN_NodeInfo
+{
+    TXN_NodeType type;
+    u32 offset;
+    u32 length;
+    u32 flags;
+} TXN_NodeInfo;
+
+// token offsets with this bit set point into the shared pool of the space
+#define TXN_SharedDataBit 0x80000000u
+
+// read-only head of every TXN_Space, pointers stay valid until the space is modified
+typedef struct TXN_SpaceView
+{
+    const TXN_NodeInfo* nodes;
+    u32 nodesTotal;
+    const char* poolBase;
+    const char* sharedBase;
+} TXN_SpaceView;
+
+static const TXN_SpaceView* TXN_spaceView(const TXN_Space* space)
+{
+    return (const TXN_SpaceView*)space;
+}
+
+static TXN_NodeType TXN_viewNodeType(const TXN_SpaceView* view, TXN_Node node)
+{
+    assert(node.id < view->nodesTotal);
+    return view->nodes[node.id].type;
+}
+
+static u32 TXN_viewTokSize(const TXN_SpaceView* view, TXN_Node node)
+{
+    assert(TXN_NodeType_Tok == TXN_viewNodeType(view, node));
+    return view->nodes[node.id].length;
+}
+
+static const char* TXN_viewTokData(const TXN_SpaceView* view, TXN_Node node)
+{
+    assert(TXN_NodeType_Tok == TXN_viewNodeType(view, node));
+    u32 offset = view->nodes[node.id].offset;
+    if (view->sharedBase && (offset & TXN_SharedDataBit))
+    {
+        return view->sharedBase + (offset & ~TXN_SharedDataBit);
+    }
+    return view->poolBase + offset;
+}
+
+static bool TXN_viewTokQuoted(const TXN_SpaceView* view, TXN_Node node)
+{
+    assert(TXN_NodeType_Tok == TXN_viewNodeType(view, node));
+    return (view->nodes[node.id].flags & TXN_NodeFlag_Quoted) != 0;
+}
+
+static u32 TXN_viewSeqLen(const TXN_SpaceView* view, TXN_Node node)
+{
+    assert(TXN_NodeType_Tok < TXN_viewNodeType(view, node));
+    return view->nodes[node.id].length;
+}
+
+static const TXN_Node* TXN_viewSeqElm(const TXN_SpaceView* view, TXN_Node node)
+{
+    assert(TXN_NodeType_Tok < TXN_viewNodeType(view, node));
+    return (const TXN_Node*)(view->poolBase + view->nodes[node.id].offset);
+}
+
+#ifdef TXN_INLINE_ACCESSORS
+# define TXN_nodeType(space, node) TXN_viewNodeType(TXN_spaceView(space), node)
+#endif
+
+
 static bool TXN_nodeIsTok(const TXN_Space* space, TXN_Node node)
 {
     return TXN_NodeType_Tok == TXN_nodeType(space, node);
@@ -104,6 +252,14 @@ u32 TXN_tokDataId(const TXN_Space* space, TXN_Node node);
 const char* TXN_tokData(const TXN_Space* space, TXN_Node node);
 bool TXN_tokQuoted(const TXN_Space* space, TXN_Node node);
 
+// dense ids 0..TXN_spaceSymsTotal-1 over distinct token payloads, in interning order.
+// a quoted and a bare token with the same text share a symbol.
+// in a space with a shared pool the pool's ids come first and are the same in every space attached to it
+u32 TXN_tokSymId(const TXN_Space* space, TXN_Node node);
+u32 TXN_spaceSymsTotal(const TXN_Space* space);
+u32 TXN_symSize(const TXN_Space* space, u32 sym);
+const char* TXN_symData(const TXN_Space* space, u32 sym);
+
 
 TXN_Node TXN_seqNew(TXN_Space* space, TXN_NodeType type, const TXN_Node* elms, u32 len);
 
@@ -114,6 +270,62 @@ const TXN_Node* TXN_seqElm(const TXN_Space* space, TXN_Node node);
 
 bool TXN_nodeDataEq(const TXN_Space* space, TXN_Node a, TXN_Node b);
 
+// token text equality across spaces, by offset alone where both spaces share the pool holding the tokens
+bool TXN_tokEq(const TXN_Space* spaceA, TXN_Node a, const TXN_Space* spaceB, TXN_Node b);
+
+
+
+// incremental seq construction over one shared element stack, seqs nest freely between begin and end
+typedef struct TXN_Builder TXN_Builder;
+
+TXN_Builder* TXN_builderNew(TXN_Space* space);
+void TXN_builderFree(TXN_Builder* builder);
+
+void TXN_builderSeqBegin(TXN_Builder* builder, TXN_NodeType type);
+void TXN_builderPush(TXN_Builder* builder, TXN_Node node);
+TXN_Node TXN_builderPushTok(TXN_Builder* builder, const char* ptr, u32 len, bool quoted);
+TXN_Node TXN_builderSeqEnd(TXN_Builder* builder);
+void TXN_builderSeqCancel(TXN_Builder* builder);
+u32 TXN_builderDepth(const TXN_Builder* builder);
+
+
+
+// path copying edits, path holds element indices from root down to the target position.
+// only the seqs along the path are recreated, the old root and everything else stay valid and shared.
+// an out of range path gives TXN_Node_Invalid
+TXN_Node TXN_editReplace(TXN_Space* space, TXN_Node root, const u32* path, u32 pathLen, TXN_Node node);
+TXN_Node TXN_editInsert(TXN_Space* space, TXN_Node root, const u32* path, u32 pathLen, TXN_Node node);
+TXN_Node TXN_editRemove(TXN_Space* space, TXN_Node root, const u32* path, u32 pathLen);
+
+
+#ifdef TXN_INLINE_ACCESSORS
+# define TXN_spaceNodesTotal(space) (TXN_spaceView(space)->nodesTotal)
+# define TXN_tokSize(space, node) TXN_viewTokSize(TXN_spaceView(space), node)
+# define TXN_tokData(space, node) TXN_viewTokData(TXN_spaceView(space), node)
+# define TXN_tokQuoted(space, node) TXN_viewTokQuoted(TXN_spaceView(space), node)
+# define TXN_seqLen(space, node) TXN_viewSeqLen(TXN_spaceView(space), node)
+# define TXN_seqElm(space, node) TXN_viewSeqElm(TXN_spaceView(space), node)
+#endif
+
+
+
+
+typedef enum TXN_TokClass
+{
+    TXN_TokClass_Ident,
+    TXN_TokClass_Int,
+    TXN_TokClass_Float,
+    TXN_TokClass_String,
+
+    TXN_NumTokClasses
+} TXN_TokClass;
+
+void TXN_spaceClassifyToks(TXN_Space* space);
+
+TXN_TokClass TXN_tokClass(const TXN_Space* space, TXN_Node node);
+s64 TXN_tokAsI64(const TXN_Space* space, TXN_Node node);
+f64 TXN_tokAsF64(const TXN_Space* space, TXN_Node node);
+
 
 
 typedef struct TXN_NodeSrcInfo
@@ -142,8 +354,60 @@ const TXN_NodeSrcInfo* TXN_nodeSrcInfo(const TXN_SpaceSrcInfo* srcInfo, TXN_Node
 
 
 
+
+typedef struct TXN_MemUsage
+{
+    u64 used;
+    u64 reserved;
+} TXN_MemUsage;
+
+// upool does not expose its capacity or hash table, pool figures count interned payload only
+typedef struct TXN_SpaceMemReport
+{
+    TXN_MemUsage nodes;
+    TXN_MemUsage pool;
+    u32 poolElms;
+    TXN_MemUsage tmpBuf;
+    TXN_MemUsage tokClasses;
+    TXN_MemUsage syms;
+    TXN_MemUsage srcInfoNodes;
+    TXN_MemUsage srcInfoFileBases;
+    TXN_MemUsage total;
+} TXN_SpaceMemReport;
+
+void TXN_spaceMemReport(const TXN_Space* space, const TXN_SpaceSrcInfo* srcInfo, TXN_SpaceMemReport* out);
+void TXN_spaceShrinkToFit(TXN_Space* space, TXN_SpaceSrcInfo* srcInfo);
+
+
+
 TXN_Node TXN_parseAsCell(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* srcInfo);
 TXN_Node TXN_parseAsList(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* srcInfo);
+TXN_Node TXN_parseBufAsList(TXN_Space* space, const char* src, u32 srcLen, TXN_SpaceSrcInfo* srcInfo);
+
+// parses straight from a read-only mapping of the file, falls back to reading it when it can't be mapped
+TXN_Node TXN_parseFile(TXN_Space* space, const char* path, TXN_SpaceSrcInfo* srcInfo);
+
+
+
+typedef struct TXN_ParseCounts
+{
+    u32 toks;
+    u32 seqs;
+    u32 maxDepth;
+    u32 maxOpenElms;
+    u32 maxTokLen;
+    u64 payloadBytes;
+} TXN_ParseCounts;
+
+// one lexing pass that builds nothing, false when the brackets don't balance.
+// payloadBytes ignores interning so it is an upper bound, the rest is exact for text that parses
+bool TXN_parseCount(const char* src, u32 srcLen, TXN_ParseCounts* out);
+
+// reserves room for a parse with these counts, the pool can only be sized while nothing is interned
+void TXN_spaceReserve(TXN_Space* space, TXN_SpaceSrcInfo* srcInfo, const TXN_ParseCounts* counts);
+
+// every later parse into space counts its text first and reserves all arrays once, off by default
+void TXN_spaceSetPrescan(TXN_Space* space, bool on);
 
 
 
@@ -169,6 +433,265 @@ u32 TXN_printML(const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, c
 
 
 
+typedef struct TXN_TokIndex TXN_TokIndex;
+
+TXN_TokIndex* TXN_tokIndexNew(const TXN_Space* space, TXN_Node root);
+void TXN_tokIndexFree(TXN_TokIndex* index);
+
+
+
+// pattern syntax:
+//   _            any node
+//   ...          any remaining elements (last in a seq pattern)
+//   %tok %seq %naked %round %square %curly     node type filters
+//   (p ...) [p ...] {p ...}    seq of that bracket type matching elements
+//   $ p          capture node matched by p
+//   ** p         p matches node itself or any descendant
+//   name "name"  token literal
+// a query starting with ** reports every node under root matching the rest.
+
+typedef struct TXN_Query TXN_Query;
+
+TXN_Query* TXN_queryNew(const char* src);
+void TXN_queryFree(TXN_Query* query);
+
+u32 TXN_queryCapturesTotal(const TXN_Query* query);
+
+typedef bool(*TXN_QueryCallback)(void* ctx, TXN_Node node, const TXN_Node* caps, u32 capsTotal);
+
+bool TXN_queryMatch(TXN_Query* query, const TXN_Space* space, TXN_Node node, TXN_Node* caps);
+u32 TXN_queryExec
+(
+    TXN_Query* query, const TXN_Space* space, TXN_Node root, const TXN_TokIndex* index,
+    TXN_QueryCallback cb, void* ctx
+);
+
+
+
+
+
+
+
+
+
+
+typedef enum TXN_VisitAct
+{
+    TXN_VisitAct_Enter,
+    TXN_VisitAct_Skip,
+    TXN_VisitAct_Stop,
+} TXN_VisitAct;
+
+// enter is called pre-order, leave post-order; a skipped node gets no leave call
+typedef TXN_VisitAct(*TXN_VisitEnterCallback)(void* ctx, TXN_Node node, u32 depth);
+typedef bool(*TXN_VisitLeaveCallback)(void* ctx, TXN_Node node, u32 depth);
+
+// fold callbacks see every element of node already folded, vals is indexed by node id
+typedef void(*TXN_FoldCallback)(void* ctx, const TXN_Space* space, TXN_Node node, void* vals);
+
+typedef struct TXN_Visitor TXN_Visitor;
+
+TXN_Visitor* TXN_visitorNew(void);
+void TXN_visitorFree(TXN_Visitor* visitor);
+
+bool TXN_visit
+(
+    TXN_Visitor* visitor, const TXN_Space* space, TXN_Node root,
+    TXN_VisitEnterCallback enter, TXN_VisitLeaveCallback leave, void* ctx
+);
+
+void TXN_fold(TXN_Visitor* visitor, const TXN_Space* space, TXN_Node root, TXN_FoldCallback cb, void* ctx, void* vals);
+void TXN_foldAll(const TXN_Space* space, TXN_FoldCallback cb, void* ctx, void* vals);
+
+
+
+enum
+{
+    TXN_ParallelGrain_Default = 4096,
+};
+
+// zero fields pick the defaults: one thread per cpu and TXN_ParallelGrain_Default
+typedef struct TXN_ParallelOpt
+{
+    u32 threads;
+    u32 grain;
+} TXN_ParallelOpt;
+
+// cb runs concurrently on subtrees bigger than grain nodes, it must be thread-safe and deterministic
+// since a subtree shared between two tasks can be folded by both
+void TXN_foldParallel
+(
+    const TXN_Space* space, TXN_Node root, TXN_FoldCallback cb, void* ctx, void* vals,
+    const TXN_ParallelOpt* opt
+);
+
+
+
+// same output as TXN_printSL/TXN_printML, seqs bigger than the grain are split into runs of their elements
+// printed concurrently, in ML only the seqs that do not fit on their line
+u32 TXN_printSlParallel
+(
+    const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_SpaceSrcInfo* srcInfo,
+    const TXN_ParallelOpt* opt
+);
+u32 TXN_printMlParallel
+(
+    const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_PrintMlOpt* mlOpt,
+    const TXN_ParallelOpt* opt
+);
+
+
+
+// reads and parses the files concurrently as lists, then appends them to space in path order.
+// roots[i] is TXN_Node_Invalid for a file that failed, srcInfo gets one file entry per path either way.
+// returns the number of files loaded
+u32 TXN_loadFiles
+(
+    TXN_Space* space, const char* const* paths, u32 count, TXN_Node* roots, TXN_SpaceSrcInfo* srcInfo,
+    const TXN_ParallelOpt* opt
+);
+
+
+
+// binary wire form: header "TXB" + flags byte, then the tree pre-order.
+// each node starts with a varint (payload << 3 | kind):
+//   kind 0/1  token/quoted token, payload byte length, bytes follow
+//   kind 2    dictionary reference, payload index of an earlier token in this message
+//   kind 3-6  naked/round/square/curly seq, payload element count, elements follow
+typedef struct TXN_BinOpt
+{
+    bool dict;
+} TXN_BinOpt;
+
+typedef bool(*TXN_BinWriteFn)(void* ctx, const void* data, u32 size);
+
+// returns bytes written, 0 if the sink failed
+u64 TXN_binEncode
+(
+    const TXN_Space* space, TXN_Node root, const TXN_BinOpt* opt, TXN_BinWriteFn write, void* ctx
+);
+TXN_Node TXN_binDecode(TXN_Space* space, const void* data, u32 size, u32* pConsumed);
+
+
+
+
+
+// evaluator for the stack language of 1.txn: a list is compiled once into bytecode and run on a vm.
+//   123 1.5 "str"        push a constant
+//   name                 call a def or builtin, push a var
+//   (f args ...)         args then f, a var holding a quotation is applied
+//   (def name body ...)  top level only, (var a b ...) pops into vars, the last popped first
+//   (if c then else)     [body ...] pushes a quotation, { body ... } runs in place
+// calls in tail position reuse the caller's frame, other frames live on the heap not the native stack.
+typedef enum TXN_EvalValType
+{
+    TXN_EvalValType_Int,
+    TXN_EvalValType_Float,
+    TXN_EvalValType_Str,
+    TXN_EvalValType_Quot,
+    TXN_EvalValType_Ary,
+
+    TXN_NumEvalValTypes
+} TXN_EvalValType;
+
+// str is a token node of the program's space, quot a function of the program, ary a handle of the vm
+typedef struct TXN_EvalVal
+{
+    TXN_EvalValType type;
+    union
+    {
+        s64 i;
+        f64 f;
+        TXN_Node str;
+        u32 quot;
+        u32 ary;
+    };
+} TXN_EvalVal;
+
+typedef enum TXN_EvalErr
+{
+    TXN_EvalErr_None,
+    TXN_EvalErr_Syntax,
+    TXN_EvalErr_Unbound,
+    TXN_EvalErr_StackUnderflow,
+    TXN_EvalErr_Type,
+    TXN_EvalErr_DivZero,
+    TXN_EvalErr_Index,
+
+    TXN_NumEvalErrs
+} TXN_EvalErr;
+
+static const char* TXN_EvalErrNameTable(TXN_EvalErr e)
+{
+    assert(e < TXN_NumEvalErrs);
+    static const char* a[TXN_NumEvalErrs] =
+    {
+        "None",
+        "Syntax",
+        "Unbound",
+        "StackUnderflow",
+        "Type",
+        "DivZero",
+        "Index",
+    };
+    return a[e];
+}
+
+typedef struct TXN_EvalErrInfo
+{
+    TXN_EvalErr err;
+    TXN_Node node;
+} TXN_EvalErrInfo;
+
+typedef struct TXN_EvalProgram TXN_EvalProgram;
+typedef struct TXN_EvalVM TXN_EvalVM;
+
+enum
+{
+    TXN_EvalCompileDepth_Max = 4096,
+};
+
+// compiles the elements of seq root, space must outlive the program,
+// forms nested deeper than TXN_EvalCompileDepth_Max fail with TXN_EvalErr_Syntax
+TXN_EvalProgram* TXN_evalCompile(const TXN_Space* space, TXN_Node root, TXN_EvalErrInfo* err);
+void TXN_evalProgramFree(TXN_EvalProgram* prog);
+
+TXN_EvalVM* TXN_evalVmNew(const TXN_EvalProgram* prog);
+void TXN_evalVmFree(TXN_EvalVM* vm);
+
+// runs the top level forms, results are left on the stack
+bool TXN_evalRun(TXN_EvalVM* vm);
+TXN_EvalErrInfo TXN_evalVmErr(const TXN_EvalVM* vm);
+
+u32 TXN_evalStackTotal(const TXN_EvalVM* vm);
+const TXN_EvalVal* TXN_evalStack(const TXN_EvalVM* vm);
+void TXN_evalStackClear(TXN_EvalVM* vm);
+
+// arrays live in a region, gc keeps the ones reachable from vars and the stack and renumbers them,
+// so array handles held outside the vm are invalid after it
+void TXN_evalGc(TXN_EvalVM* vm);
+u64 TXN_evalHeapSize(const TXN_EvalVM* vm);
+
+u32 TXN_evalAryLen(const TXN_EvalVM* vm, TXN_EvalVal ary);
+TXN_EvalVal TXN_evalAryElm(const TXN_EvalVM* vm, TXN_EvalVal ary, u32 i);
+
+
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+
+
+
+
+
+
+
 
 
 
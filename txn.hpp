@@ -0,0 +1,181 @@
+#pragma once
+
+
+
+#include "txn.h"
+
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+
+// header-only C++17 view layer over the C API, no allocation beyond what TXN_Space does itself
+
+namespace txn
+{
+
+
+class Seq;
+
+
+class Node
+{
+public:
+    constexpr Node() noexcept : space_(nullptr), node_{ (u32)-1 } {}
+    constexpr Node(const TXN_Space* space, TXN_Node node) noexcept : space_(space), node_(node) {}
+
+    constexpr const TXN_Space* space() const noexcept { return space_; }
+    constexpr TXN_Node raw() const noexcept { return node_; }
+    constexpr u32 id() const noexcept { return node_.id; }
+    constexpr bool valid() const noexcept { return node_.id != (u32)-1; }
+    constexpr explicit operator bool() const noexcept { return valid(); }
+
+    TXN_NodeType type() const noexcept { return TXN_nodeType(space_, node_); }
+    bool isTok() const noexcept { return TXN_nodeIsTok(space_, node_); }
+    bool isSeq() const noexcept { return TXN_nodeIsSeq(space_, node_); }
+    bool isSeqNaked() const noexcept { return TXN_nodeIsSeqNaked(space_, node_); }
+    bool isSeqRound() const noexcept { return TXN_nodeIsSeqRound(space_, node_); }
+    bool isSeqSquare() const noexcept { return TXN_nodeIsSeqSquare(space_, node_); }
+    bool isSeqCurly() const noexcept { return TXN_nodeIsSeqCurly(space_, node_); }
+
+    std::string_view tok() const noexcept
+    {
+        assert(isTok());
+        return std::string_view(TXN_tokData(space_, node_), TXN_tokSize(space_, node_));
+    }
+    bool quoted() const noexcept { return TXN_tokQuoted(space_, node_); }
+    u32 symId() const noexcept { return TXN_tokSymId(space_, node_); }
+    TXN_TokClass tokClass() const noexcept { return TXN_tokClass(space_, node_); }
+    s64 asI64() const noexcept { return TXN_tokAsI64(space_, node_); }
+    f64 asF64() const noexcept { return TXN_tokAsF64(space_, node_); }
+
+    inline Seq seq() const noexcept;
+
+    bool dataEq(Node b) const noexcept { return TXN_nodeDataEq(space_, node_, b.node_); }
+
+    constexpr bool operator==(Node b) const noexcept { return (space_ == b.space_) && (node_.id == b.node_.id); }
+    constexpr bool operator!=(Node b) const noexcept { return !(*this == b); }
+
+private:
+    const TXN_Space* space_;
+    TXN_Node node_;
+};
+
+static_assert(std::is_trivially_copyable<Node>::value, "txn::Node must stay a plain view");
+
+
+
+
+class Seq
+{
+public:
+    typedef TXN_Node value_type;
+    typedef const TXN_Node* iterator;
+    typedef const TXN_Node* const_iterator;
+    typedef std::size_t size_type;
+
+    constexpr Seq() noexcept : space_(nullptr), elms_(nullptr), len_(0) {}
+    constexpr Seq(const TXN_Space* space, const TXN_Node* elms, u32 len) noexcept : space_(space), elms_(elms), len_(len) {}
+
+    constexpr const TXN_Space* space() const noexcept { return space_; }
+    constexpr const TXN_Node* data() const noexcept { return elms_; }
+    constexpr iterator begin() const noexcept { return elms_; }
+    constexpr iterator end() const noexcept { return elms_ + len_; }
+    constexpr u32 size() const noexcept { return len_; }
+    constexpr bool empty() const noexcept { return 0 == len_; }
+
+    constexpr TXN_Node operator[](u32 i) const noexcept { return elms_[i]; }
+    Node at(u32 i) const noexcept
+    {
+        assert(i < len_);
+        return Node(space_, elms_[i]);
+    }
+
+private:
+    const TXN_Space* space_;
+    const TXN_Node* elms_;
+    u32 len_;
+};
+
+static_assert(std::is_trivially_copyable<Seq>::value, "txn::Seq must stay a plain view");
+
+
+inline Seq Node::seq() const noexcept
+{
+    assert(isSeq());
+    return Seq(space_, TXN_seqElm(space_, node_), TXN_seqLen(space_, node_));
+}
+
+
+
+
+class Space
+{
+public:
+    Space() : space_(TXN_spaceNew()) {}
+    explicit Space(TXN_Space* space) noexcept : space_(space) {}
+    ~Space()
+    {
+        if (space_)
+        {
+            TXN_spaceFree(space_);
+        }
+    }
+
+    Space(const Space&) = delete;
+    Space& operator=(const Space&) = delete;
+    Space(Space&& b) noexcept : space_(b.space_)
+    {
+        b.space_ = nullptr;
+    }
+    Space& operator=(Space&& b) noexcept
+    {
+        if (this != &b)
+        {
+            if (space_)
+            {
+                TXN_spaceFree(space_);
+            }
+            space_ = b.space_;
+            b.space_ = nullptr;
+        }
+        return *this;
+    }
+
+    TXN_Space* get() const noexcept { return space_; }
+    TXN_Space* release() noexcept
+    {
+        TXN_Space* space = space_;
+        space_ = nullptr;
+        return space;
+    }
+
+    u32 nodesTotal() const noexcept { return TXN_spaceNodesTotal(space_); }
+    Node node(TXN_Node node) const noexcept { return Node(space_, node); }
+
+    Node tok(std::string_view str, bool quoted = false) noexcept
+    {
+        return Node(space_, TXN_tokFromBuf(space_, str.data(), (u32)str.size(), quoted));
+    }
+    Node seq(TXN_NodeType type, const TXN_Node* elms, u32 len) noexcept
+    {
+        return Node(space_, TXN_seqNew(space_, type, elms, len));
+    }
+
+    Node parseAsCell(const char* src, TXN_SpaceSrcInfo* srcInfo = nullptr) noexcept
+    {
+        return Node(space_, TXN_parseAsCell(space_, src, srcInfo));
+    }
+    Node parseAsList(const char* src, TXN_SpaceSrcInfo* srcInfo = nullptr) noexcept
+    {
+        return Node(space_, TXN_parseAsList(space_, src, srcInfo));
+    }
+
+    void classifyToks() noexcept { TXN_spaceClassifyToks(space_); }
+
+private:
+    TXN_Space* space_;
+};
+
+
+}
@@ -2,6 +2,7 @@
 
 
 
+#undef TXN_INLINE_ACCESSORS
 #include "txn.h"
 
 
@@ -14,12 +15,31 @@
 #include <math.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <limits.h>
 
 #include <fileu.h>
 #include <upool.h>
 
 
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+# define TXN_USE_SSE2
+# include <emmintrin.h>
+#endif
+
+
+#ifdef TXN_STATS
+# if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+# elif defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+# else
+#  include <time.h>
+# endif
+#endif
+
+
+
 
 #ifdef ARYLEN
 # undef ARYLEN
@@ -73,6 +93,19 @@ static u32 align(u32 x, u32 a)
 
 
 
+static u32 ctz32(u32 x)
+{
+    assert(x);
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return i;
+#else
+    return __builtin_ctz(x);
+#endif
+}
+
+
 
 
 
@@ -80,13 +113,6 @@ static u32 align(u32 x, u32 a)
 
 
 
-typedef struct TXN_NodeInfo
-{
-    TXN_NodeType type;
-    u32 offset;
-    u32 length;
-    u32 quoted;
-} TXN_NodeInfo;
 
 typedef vec_t(TXN_NodeInfo) TXN_NodeInfoVec;
 
@@ -100,13 +126,284 @@ typedef struct TXN_SeqDefFrame
 typedef vec_t(TXN_SeqDefFrame) TXN_SeqDefFrameVec;
 
 
+typedef struct TXN_Builder
+{
+    TXN_Space* space;
+    TXN_NodeVec seqDefStack[1];
+    TXN_SeqDefFrameVec seqDefFrameStack[1];
+} TXN_Builder;
+
+void TXN_builderDeinit(TXN_Builder* builder);
+
+
+typedef vec_t(u8) TXN_TokClassVec;
+
+typedef union TXN_TokNum
+{
+    s64 i;
+    f64 f;
+} TXN_TokNum;
+
+typedef vec_t(TXN_TokNum) TXN_TokNumVec;
+
+
+typedef struct TXN_IdMapSlot
+{
+    u32 key;
+    u32 val;
+} TXN_IdMapSlot;
+
+typedef vec_t(TXN_IdMapSlot) TXN_IdMapSlotVec;
+
+typedef struct TXN_IdMap
+{
+    TXN_IdMapSlotVec slots[1];
+    u32 count;
+} TXN_IdMap;
+
+
+typedef struct TXN_SymInfo
+{
+    u32 offset;
+    u32 length;
+} TXN_SymInfo;
+
+typedef vec_t(TXN_SymInfo) TXN_SymInfoVec;
+
+
+// open addressing over syms, slots hold a sym or (u32)-1. offsets index data
+typedef struct TXN_SharedPool
+{
+    vec_char data[1];
+    TXN_SymInfoVec syms[1];
+    vec_u32 slots[1];
+    bool frozen;
+} TXN_SharedPool;
+
+u32 TXN_sharedPoolFind(const TXN_SharedPool* pool, const void* data, u32 len);
+
+
 typedef struct TXN_Space
 {
+    TXN_SpaceView view[1];
     TXN_NodeInfoVec nodes[1];
     upool_t dataPool;
     vec_char tmpBuf[1];
+    TXN_TokClassVec tokClasses[1];
+    TXN_TokNumVec tokNums[1];
+    vec_u32 tokSyms[1];
+    TXN_SymInfoVec syms[1];
+    TXN_IdMap symMap[1];
+    const TXN_SharedPool* shared;
+    u64 poolBytes;
+    u32 poolElms;
+    bool prescan;
+#ifdef TXN_STATS
+    TXN_Stats stats[1];
+#endif
 } TXN_Space;
 
+static void TXN_spaceViewSync(TXN_Space* space)
+{
+    space->view->nodes = space->nodes->data;
+    space->view->nodesTotal = space->nodes->length;
+}
+
+static u32 TXN_spaceSharedSyms(const TXN_Space* space)
+{
+    return space->shared ? space->shared->syms->length : 0;
+}
+
+static const char* TXN_tokDataAt(const TXN_Space* space, u32 offset)
+{
+    if (space->shared && (offset & TXN_SharedDataBit))
+    {
+        return space->shared->data->data + (offset & ~TXN_SharedDataBit);
+    }
+    return upool_elmData(space->dataPool, offset);
+}
+
+
+
+
+
+#ifdef TXN_STATS
+
+# define TXN_STAT(x) x
+
+# define TXN_spaceStatsOf(space) (((TXN_Space*)(space))->stats)
+
+# define TXN_vecPush(space, v, x)\
+    do\
+    {\
+        u32 cap0__ = (v)->capacity;\
+        vec_push(v, x);\
+        if ((v)->capacity != cap0__) ++TXN_spaceStatsOf(space)->vecGrows;\
+    } while (0)
+
+static u64 TXN_statsNow(void)
+{
+# if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+# else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+# endif
+}
+
+#else
+
+# define TXN_STAT(x)
+
+# define TXN_vecPush(space, v, x) ((void)(space), vec_push(v, x))
+
+#endif
+
+
+
+
+
+
+u32 TXN_poolElm(TXN_Space* space, const void* data, u32 size);
+
+u32 TXN_tokFlags(const char* str, u32 len, bool quoted);
+TXN_Node TXN_tokFromTmpBuf(TXN_Space* space, u32 len, u32 flags);
+
+// appends copies of src nodes [begin, end), which may only reference each other, returns the id of the first copy
+u32 TXN_spaceImport(TXN_Space* space, const TXN_Space* src, u32 begin, u32 end);
+
+
+
+
+// workers pull work through shared counters; a thread that fails to start just leaves its share to the others
+typedef void(*TXN_WorkerFn)(void* ctx, u32 worker);
+
+u32 TXN_cpuCount(void);
+u32 TXN_atomicInc(volatile u32* p);
+void TXN_runWorkers(u32 n, TXN_WorkerFn fn, void* ctx);
+
+
+// subtree size from the id span down the first-element chain, exact for parsed trees
+static u32 TXN_nodeEstSize(const TXN_Space* space, TXN_Node node)
+{
+    TXN_Node low = node;
+    const TXN_NodeInfo* info = space->nodes->data + low.id;
+    while ((info->type > TXN_NodeType_Tok) && info->length)
+    {
+        low = ((const TXN_Node*)upool_elmData(space->dataPool, info->offset))[0];
+        info = space->nodes->data + low.id;
+    }
+    assert(low.id <= node.id);
+    return node.id - low.id + 1;
+}
+
+
+
+
+
+static u32 TXN_hashBytes(const void* data, u32 size)
+{
+    const u8* p = data;
+    u32 h = 2166136261u;
+    for (u32 i = 0; i < size; ++i)
+    {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static u32 TXN_hashU32(u32 x)
+{
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+
+
+
+static void TXN_idMapFree(TXN_IdMap* map)
+{
+    vec_free(map->slots);
+    map->count = 0;
+}
+
+static void TXN_idMapReset(TXN_IdMap* map, u32 capacity)
+{
+    u32 n = 16;
+    while (n < capacity * 2)
+    {
+        n *= 2;
+    }
+    vec_resize(map->slots, n);
+    memset(map->slots->data, 0xff, sizeof(TXN_IdMapSlot)*n);
+    map->count = 0;
+}
+
+static u32* TXN_idMapGet(const TXN_IdMap* map, u32 key)
+{
+    assert(key != (u32)-1);
+    if (!map->slots->length)
+    {
+        return NULL;
+    }
+    u32 mask = map->slots->length - 1;
+    for (u32 i = TXN_hashU32(key) & mask;; i = (i + 1) & mask)
+    {
+        TXN_IdMapSlot* slot = map->slots->data + i;
+        if (slot->key == key)
+        {
+            return &slot->val;
+        }
+        if (slot->key == (u32)-1)
+        {
+            return NULL;
+        }
+    }
+}
+
+static u32* TXN_idMapPut(TXN_IdMap* map, u32 key, u32 val, bool* isNew)
+{
+    assert(key != (u32)-1);
+    if ((map->count + 1) * 2 > map->slots->length)
+    {
+        TXN_IdMapSlotVec old = *map->slots;
+        memset(map->slots, 0, sizeof(map->slots));
+        TXN_idMapReset(map, max(map->count + 1, old.length));
+        for (u32 i = 0; i < old.length; ++i)
+        {
+            if (old.data[i].key != (u32)-1)
+            {
+                TXN_idMapPut(map, old.data[i].key, old.data[i].val, NULL);
+            }
+        }
+        vec_free(&old);
+    }
+    u32 mask = map->slots->length - 1;
+    for (u32 i = TXN_hashU32(key) & mask;; i = (i + 1) & mask)
+    {
+        TXN_IdMapSlot* slot = map->slots->data + i;
+        if (slot->key == key)
+        {
+            if (isNew) *isNew = false;
+            return &slot->val;
+        }
+        if (slot->key == (u32)-1)
+        {
+            slot->key = key;
+            slot->val = val;
+            ++map->count;
+            if (isNew) *isNew = true;
+            return &slot->val;
+        }
+    }
+}
+
 
 
 
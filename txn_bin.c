@@ -0,0 +1,306 @@
+#include "txn_a.h"
+
+
+
+
+enum
+{
+    TXN_BinTag_Tok,
+    TXN_BinTag_TokQuoted,
+    TXN_BinTag_TokRef,
+    TXN_BinTag_Seq,
+
+    TXN_BinTagBits = 3,
+    TXN_BinTagMask = (1 << TXN_BinTagBits) - 1,
+
+    TXN_BinFlag_Dict = 1 << 0,
+
+    TXN_BinFlushSize = 64 * 1024,
+};
+
+static const char TXN_BinMagic[3] = { 'T', 'X', 'B' };
+
+
+
+
+typedef struct TXN_BinEncLevel
+{
+    TXN_Node node;
+    u32 p;
+} TXN_BinEncLevel;
+
+typedef vec_t(TXN_BinEncLevel) TXN_BinEncStack;
+
+
+typedef struct TXN_BinEncoder
+{
+    const TXN_Space* space;
+    TXN_BinWriteFn write;
+    void* ctx;
+    vec_char out[1];
+    u64 total;
+    bool failed;
+    bool dict;
+    TXN_IdMap dictMaps[2];
+    u32 dictSize;
+} TXN_BinEncoder;
+
+
+
+static void TXN_binFlush(TXN_BinEncoder* enc)
+{
+    if (enc->out->length && !enc->failed)
+    {
+        enc->failed = !enc->write(enc->ctx, enc->out->data, enc->out->length);
+        enc->total += enc->out->length;
+    }
+    vec_clear(enc->out);
+}
+
+static void TXN_binPutVarint(TXN_BinEncoder* enc, u64 x)
+{
+    while (x >= 0x80)
+    {
+        vec_push(enc->out, (char)(x | 0x80));
+        x >>= 7;
+    }
+    vec_push(enc->out, (char)x);
+}
+
+static void TXN_binPutBytes(TXN_BinEncoder* enc, const char* data, u32 size)
+{
+    if (enc->out->length + size > TXN_BinFlushSize)
+    {
+        TXN_binFlush(enc);
+    }
+    if (size >= TXN_BinFlushSize)
+    {
+        if (!enc->failed)
+        {
+            enc->failed = !enc->write(enc->ctx, data, size);
+            enc->total += size;
+        }
+        return;
+    }
+    vec_pusharr(enc->out, data, size);
+}
+
+
+
+static void TXN_binPutTok(TXN_BinEncoder* enc, const TXN_NodeInfo* info)
+{
+    bool quoted = (info->flags & TXN_NodeFlag_Quoted) != 0;
+    if (enc->dict)
+    {
+        bool isNew;
+        u32* index = TXN_idMapPut(enc->dictMaps + quoted, info->offset, enc->dictSize, &isNew);
+        if (!isNew)
+        {
+            TXN_binPutVarint(enc, ((u64)*index << TXN_BinTagBits) | TXN_BinTag_TokRef);
+            return;
+        }
+        ++enc->dictSize;
+    }
+    const char* str = TXN_tokDataAt(enc->space, info->offset);
+    TXN_binPutVarint(enc, ((u64)info->length << TXN_BinTagBits) | (quoted ? TXN_BinTag_TokQuoted : TXN_BinTag_Tok));
+    TXN_binPutBytes(enc, str, info->length);
+}
+
+
+
+u64 TXN_binEncode
+(
+    const TXN_Space* space, TXN_Node root, const TXN_BinOpt* opt, TXN_BinWriteFn write, void* ctx
+)
+{
+    TXN_BinEncoder enc[1] = { { space, write, ctx } };
+    enc->dict = opt && opt->dict;
+    TXN_idMapReset(enc->dictMaps + 0, 64);
+    TXN_idMapReset(enc->dictMaps + 1, 64);
+
+    vec_pusharr(enc->out, TXN_BinMagic, sizeof(TXN_BinMagic));
+    vec_push(enc->out, (char)(enc->dict ? TXN_BinFlag_Dict : 0));
+
+    TXN_BinEncStack stack[1] = { 0 };
+    TXN_Node node = root;
+    const TXN_NodeInfo* info = NULL;
+    TXN_BinEncLevel* top = NULL;
+enter:
+    if (enc->out->length >= TXN_BinFlushSize)
+    {
+        TXN_binFlush(enc);
+    }
+    info = space->nodes->data + node.id;
+    if (TXN_NodeType_Tok == info->type)
+    {
+        TXN_binPutTok(enc, info);
+    }
+    else
+    {
+        u32 kind = TXN_BinTag_Seq + (info->type - TXN_NodeType_SeqNaked);
+        TXN_binPutVarint(enc, ((u64)info->length << TXN_BinTagBits) | kind);
+        TXN_BinEncLevel l = { node, 0 };
+        vec_push(stack, l);
+    }
+next:
+    if (stack->length)
+    {
+        top = &vec_last(stack);
+        info = space->nodes->data + top->node.id;
+        if (top->p < info->length)
+        {
+            node = ((const TXN_Node*)upool_elmData(space->dataPool, info->offset))[top->p++];
+            goto enter;
+        }
+        vec_pop(stack);
+        goto next;
+    }
+
+    TXN_binFlush(enc);
+    bool failed = enc->failed;
+    u64 total = enc->total;
+    vec_free(stack);
+    TXN_idMapFree(enc->dictMaps + 1);
+    TXN_idMapFree(enc->dictMaps + 0);
+    vec_free(enc->out);
+    return failed ? 0 : total;
+}
+
+
+
+
+
+typedef struct TXN_BinDecoder
+{
+    const u8* data;
+    u32 size;
+    u32 cur;
+} TXN_BinDecoder;
+
+
+static bool TXN_binGetVarint(TXN_BinDecoder* dec, u64* out)
+{
+    u64 x = 0;
+    for (u32 shift = 0; shift < 64; shift += 7)
+    {
+        if (dec->cur >= dec->size)
+        {
+            return false;
+        }
+        u8 b = dec->data[dec->cur++];
+        x |= (u64)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+        {
+            *out = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+TXN_Node TXN_binDecode(TXN_Space* space, const void* data, u32 size, u32* pConsumed)
+{
+    TXN_BinDecoder dec[1] = { { data, size, 0 } };
+    if ((size < sizeof(TXN_BinMagic) + 1) || memcmp(data, TXN_BinMagic, sizeof(TXN_BinMagic)))
+    {
+        return TXN_Node_Invalid;
+    }
+    dec->cur = sizeof(TXN_BinMagic);
+    u8 flags = dec->data[dec->cur++];
+
+    TXN_Builder builder[1] = { { space } };
+    vec_u32 remains[1] = { 0 };
+    TXN_NodeVec dict[1] = { 0 };
+    TXN_Node node = TXN_Node_Invalid;
+    for (;;)
+    {
+        u64 tag;
+        if (!TXN_binGetVarint(dec, &tag))
+        {
+            goto failed;
+        }
+        switch (tag & TXN_BinTagMask)
+        {
+        case TXN_BinTag_Tok:
+        case TXN_BinTag_TokQuoted:
+        {
+            u64 len = tag >> TXN_BinTagBits;
+            if (len > dec->size - dec->cur)
+            {
+                goto failed;
+            }
+            bool quoted = TXN_BinTag_TokQuoted == (tag & TXN_BinTagMask);
+            node = TXN_tokFromBuf(space, (const char*)dec->data + dec->cur, (u32)len, quoted);
+            dec->cur += (u32)len;
+            if (flags & TXN_BinFlag_Dict)
+            {
+                vec_push(dict, node);
+            }
+            break;
+        }
+        case TXN_BinTag_TokRef:
+        {
+            u64 index = tag >> TXN_BinTagBits;
+            if (index >= dict->length)
+            {
+                goto failed;
+            }
+            node = dict->data[index];
+            break;
+        }
+        case TXN_BinTag_Seq + 0:
+        case TXN_BinTag_Seq + 1:
+        case TXN_BinTag_Seq + 2:
+        case TXN_BinTag_Seq + 3:
+        {
+            TXN_NodeType type = TXN_NodeType_SeqNaked + (u32)((tag & TXN_BinTagMask) - TXN_BinTag_Seq);
+            u64 len = tag >> TXN_BinTagBits;
+            if (len > dec->size - dec->cur)
+            {
+                goto failed;
+            }
+            TXN_builderSeqBegin(builder, type);
+            vec_push(remains, (u32)len);
+            node = TXN_Node_Invalid;
+            break;
+        }
+        default:
+            goto failed;
+        }
+
+        for (;;)
+        {
+            if (TXN_Node_Invalid.id != node.id)
+            {
+                if (!remains->length)
+                {
+                    goto done;
+                }
+                TXN_builderPush(builder, node);
+                --vec_last(remains);
+            }
+            if (!remains->length || vec_last(remains))
+            {
+                break;
+            }
+            vec_pop(remains);
+            node = TXN_builderSeqEnd(builder);
+        }
+    }
+done:
+    if (pConsumed)
+    {
+        *pConsumed = dec->cur;
+    }
+    vec_free(dict);
+    vec_free(remains);
+    TXN_builderDeinit(builder);
+    return node;
+failed:
+    vec_free(dict);
+    vec_free(remains);
+    TXN_builderDeinit(builder);
+    return TXN_Node_Invalid;
+}
@@ -0,0 +1,72 @@
+#include "txn_a.h"
+
+
+
+
+TXN_Builder* TXN_builderNew(TXN_Space* space)
+{
+    TXN_Builder* builder = zalloc(sizeof(*builder));
+    builder->space = space;
+    return builder;
+}
+
+void TXN_builderFree(TXN_Builder* builder)
+{
+    TXN_builderDeinit(builder);
+    free(builder);
+}
+
+void TXN_builderDeinit(TXN_Builder* builder)
+{
+    vec_free(builder->seqDefFrameStack);
+    vec_free(builder->seqDefStack);
+}
+
+
+
+
+
+void TXN_builderSeqBegin(TXN_Builder* builder, TXN_NodeType type)
+{
+    assert(type > TXN_NodeType_Tok);
+    TXN_SeqDefFrame f = { type, builder->seqDefStack->length };
+    TXN_vecPush(builder->space, builder->seqDefFrameStack, f);
+}
+
+void TXN_builderPush(TXN_Builder* builder, TXN_Node node)
+{
+    assert(builder->seqDefFrameStack->length > 0);
+    TXN_vecPush(builder->space, builder->seqDefStack, node);
+}
+
+TXN_Node TXN_builderPushTok(TXN_Builder* builder, const char* ptr, u32 len, bool quoted)
+{
+    TXN_Node node = TXN_tokFromBuf(builder->space, ptr, len, quoted);
+    TXN_builderPush(builder, node);
+    return node;
+}
+
+TXN_Node TXN_builderSeqEnd(TXN_Builder* builder)
+{
+    assert(builder->seqDefFrameStack->length > 0);
+    TXN_SeqDefFrame f = vec_last(builder->seqDefFrameStack);
+    vec_pop(builder->seqDefFrameStack);
+    u32 len = builder->seqDefStack->length - f.p;
+    TXN_Node* elms = builder->seqDefStack->data + f.p;
+    TXN_Node node = TXN_seqNew(builder->space, f.seqType, elms, len);
+    vec_resize(builder->seqDefStack, f.p);
+    return node;
+}
+
+void TXN_builderSeqCancel(TXN_Builder* builder)
+{
+    assert(builder->seqDefFrameStack->length > 0);
+    TXN_SeqDefFrame f = vec_last(builder->seqDefFrameStack);
+    vec_pop(builder->seqDefFrameStack);
+    vec_resize(builder->seqDefStack, f.p);
+}
+
+u32 TXN_builderDepth(const TXN_Builder* builder)
+{
+    return builder->seqDefFrameStack->length;
+}
@@ -0,0 +1,223 @@
+#include "txn_a.h"
+
+
+
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+# define TXN_LITTLE_ENDIAN
+#endif
+
+
+
+
+static bool TXN_isDigit(char c)
+{
+    return ('0' <= c) && (c <= '9');
+}
+
+
+static u32 TXN_digitsSpan(const char* s, u32 len)
+{
+    u32 i = 0;
+#ifdef TXN_LITTLE_ENDIAN
+    for (; i + 8 <= len; i += 8)
+    {
+        u64 x;
+        memcpy(&x, s + i, 8);
+        u64 hi = x & 0xF0F0F0F0F0F0F0F0ull;
+        u64 lo = ((x + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4;
+        if ((hi | lo) != 0x3333333333333333ull)
+        {
+            break;
+        }
+    }
+#endif
+    while ((i < len) && TXN_isDigit(s[i]))
+    {
+        ++i;
+    }
+    return i;
+}
+
+
+static u64 TXN_parseDigits8(const char* s)
+{
+#ifdef TXN_LITTLE_ENDIAN
+    u64 x;
+    memcpy(&x, s, 8);
+    x = (x & 0x0F0F0F0F0F0F0F0Full) * 2561 >> 8;
+    x = (x & 0x00FF00FF00FF00FFull) * 6553601 >> 16;
+    return (x & 0x0000FFFF0000FFFFull) * 42949672960001ull >> 32;
+#else
+    u64 x = 0;
+    for (u32 i = 0; i < 8; ++i)
+    {
+        x = x * 10 + (s[i] - '0');
+    }
+    return x;
+#endif
+}
+
+
+static u64 TXN_parseDigits(const char* s, u32 n)
+{
+    assert(n <= 19);
+    u64 x = 0;
+    u32 head = n % 8;
+    for (u32 i = 0; i < head; ++i)
+    {
+        x = x * 10 + (s[i] - '0');
+    }
+    for (u32 i = head; i < n; i += 8)
+    {
+        x = x * 100000000ull + TXN_parseDigits8(s + i);
+    }
+    return x;
+}
+
+
+
+
+static TXN_TokClass TXN_classifyTok(const char* s, u32 len, TXN_TokNum* num)
+{
+    num->i = 0;
+    u32 i = 0;
+    bool neg = false;
+    if ((i < len) && (('+' == s[i]) || ('-' == s[i])))
+    {
+        neg = '-' == s[i];
+        ++i;
+    }
+    u32 nd = TXN_digitsSpan(s + i, len - i);
+    i += nd;
+    if ((i == len) && (nd > 0) && (nd <= 19))
+    {
+        u64 x = TXN_parseDigits(s + i - nd, nd);
+        if (x <= (u64)INT64_MAX)
+        {
+            num->i = neg ? -(s64)x : (s64)x;
+            return TXN_TokClass_Int;
+        }
+        if (neg && (x == (u64)INT64_MAX + 1))
+        {
+            num->i = INT64_MIN;
+            return TXN_TokClass_Int;
+        }
+    }
+    if ((i < len) && ('.' == s[i]))
+    {
+        ++i;
+        u32 nf = TXN_digitsSpan(s + i, len - i);
+        i += nf;
+        nd += nf;
+    }
+    if (!nd)
+    {
+        return TXN_TokClass_Ident;
+    }
+    if ((i < len) && (('e' == s[i]) || ('E' == s[i])))
+    {
+        ++i;
+        if ((i < len) && (('+' == s[i]) || ('-' == s[i])))
+        {
+            ++i;
+        }
+        u32 ne = TXN_digitsSpan(s + i, len - i);
+        if (!ne)
+        {
+            return TXN_TokClass_Ident;
+        }
+        i += ne;
+    }
+    if (i != len)
+    {
+        return TXN_TokClass_Ident;
+    }
+    assert(!s[len]);
+    num->f = strtod(s, NULL);
+    return TXN_TokClass_Float;
+}
+
+
+static TXN_TokClass TXN_classifyNode(const TXN_Space* space, const TXN_NodeInfo* info, TXN_TokNum* num)
+{
+    if (info->flags & TXN_NodeFlag_Quoted)
+    {
+        num->i = 0;
+        return TXN_TokClass_String;
+    }
+    const char* str = TXN_tokDataAt(space, info->offset);
+    return TXN_classifyTok(str, info->length, num);
+}
+
+
+
+
+void TXN_spaceClassifyToks(TXN_Space* space)
+{
+    u32 begin = space->tokClasses->length;
+    u32 end = space->nodes->length;
+    vec_resize(space->tokClasses, end);
+    vec_resize(space->tokNums, end);
+    for (u32 i = begin; i < end; ++i)
+    {
+        const TXN_NodeInfo* info = space->nodes->data + i;
+        TXN_TokNum* num = space->tokNums->data + i;
+        if (info->type != TXN_NodeType_Tok)
+        {
+            space->tokClasses->data[i] = TXN_TokClass_Ident;
+            num->i = 0;
+            continue;
+        }
+        space->tokClasses->data[i] = TXN_classifyNode(space, info, num);
+    }
+}
+
+
+
+
+static TXN_TokClass TXN_tokClassNum(const TXN_Space* space, TXN_Node node, TXN_TokNum* num)
+{
+    const TXN_NodeInfo* info = space->nodes->data + node.id;
+    assert(TXN_NodeType_Tok == info->type);
+    if (node.id < space->tokClasses->length)
+    {
+        *num = space->tokNums->data[node.id];
+        return space->tokClasses->data[node.id];
+    }
+    return TXN_classifyNode(space, info, num);
+}
+
+
+TXN_TokClass TXN_tokClass(const TXN_Space* space, TXN_Node node)
+{
+    TXN_TokNum num;
+    return TXN_tokClassNum(space, node, &num);
+}
+
+s64 TXN_tokAsI64(const TXN_Space* space, TXN_Node node)
+{
+    TXN_TokNum num;
+    switch (TXN_tokClassNum(space, node, &num))
+    {
+    case TXN_TokClass_Int:
+        return num.i;
+    case TXN_TokClass_Float:
+        return (s64)num.f;
+    default:
+        return 0;
+    }
+}
+
+f64 TXN_tokAsF64(const TXN_Space* space, TXN_Node node)
+{
+    TXN_TokNum num;
+    switch (TXN_tokClassNum(space, node, &num))
+    {
+    case TXN_TokClass_Int:
+        return (f64)num.i;
+    case TXN_TokClass_Float:
+        return num.f;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,102 @@
+#include "txn_a.h"
+
+
+
+
+typedef enum TXN_EditOp
+{
+    TXN_EditOp_Replace,
+    TXN_EditOp_Insert,
+    TXN_EditOp_Remove,
+} TXN_EditOp;
+
+
+
+static TXN_Node TXN_edit
+(
+    TXN_Space* space, TXN_Node root, const u32* path, u32 pathLen, TXN_EditOp op, TXN_Node node
+)
+{
+    if (!pathLen)
+    {
+        return (TXN_EditOp_Replace == op) ? node : TXN_Node_Invalid;
+    }
+
+    TXN_NodeVec parents[1] = { 0 };
+    TXN_Node cur = root;
+    for (u32 i = 0; i < pathLen; ++i)
+    {
+        const TXN_NodeInfo* info = space->nodes->data + cur.id;
+        u32 end = ((i + 1 == pathLen) && (TXN_EditOp_Insert == op)) ? info->length + 1 : info->length;
+        if ((TXN_NodeType_Tok == info->type) || (path[i] >= end))
+        {
+            vec_free(parents);
+            return TXN_Node_Invalid;
+        }
+        vec_push(parents, cur);
+        if (i + 1 < pathLen)
+        {
+            cur = ((const TXN_Node*)upool_elmData(space->dataPool, info->offset))[path[i]];
+        }
+    }
+
+    TXN_NodeVec elms[1] = { 0 };
+    for (u32 i = pathLen; i > 0; --i)
+    {
+        TXN_Node parent = parents->data[i - 1];
+        const TXN_NodeInfo* info = space->nodes->data + parent.id;
+        TXN_NodeType type = info->type;
+        u32 p = path[i - 1];
+        // room for an insert also keeps data non-null when the seq is empty
+        vec_reserve(elms, info->length + 1);
+        vec_resize(elms, info->length);
+        if (info->length)
+        {
+            memcpy(elms->data, upool_elmData(space->dataPool, info->offset), sizeof(TXN_Node) * info->length);
+        }
+        if (i < pathLen)
+        {
+            elms->data[p] = node;
+        }
+        else
+        {
+            switch (op)
+            {
+            case TXN_EditOp_Replace:
+                elms->data[p] = node;
+                break;
+            case TXN_EditOp_Insert:
+                vec_insert(elms, p, node);
+                break;
+            case TXN_EditOp_Remove:
+                vec_splice(elms, p, 1);
+                break;
+            default:
+                assert(false);
+                break;
+            }
+        }
+        node = TXN_seqNew(space, type, elms->data, elms->length);
+    }
+    vec_free(elms);
+    vec_free(parents);
+    return node;
+}
+
+
+
+
+TXN_Node TXN_editReplace(TXN_Space* space, TXN_Node root, const u32* path, u32 pathLen, TXN_Node node)
+{
+    return TXN_edit(space, root, path, pathLen, TXN_EditOp_Replace, node);
+}
+
+TXN_Node TXN_editInsert(TXN_Space* space, TXN_Node root, const u32* path, u32 pathLen, TXN_Node node)
+{
+    return TXN_edit(space, root, path, pathLen, TXN_EditOp_Insert, node);
+}
+
+TXN_Node TXN_editRemove(TXN_Space* space, TXN_Node root, const u32* path, u32 pathLen)
+{
+    return TXN_edit(space, root, path, pathLen, TXN_EditOp_Remove, TXN_Node_Invalid);
+}
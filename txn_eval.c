@@ -0,0 +1,1767 @@
+#include "txn_a.h"
+
+
+
+#if defined(__GNUC__) || defined(__clang__)
+# define TXN_EVAL_THREADED
+#endif
+
+#ifdef _MSC_VER
+# define TXN_RESTRICT __restrict
+#else
+# define TXN_RESTRICT restrict
+#endif
+
+
+
+
+#define TXN_EVAL_OPS(X)                                                 \
+    X(Const) X(Quot) X(Load) X(Store) X(LoadGlobal) X(StoreGlobal)      \
+    X(Call) X(CallVal) X(Apply) X(TailCall) X(TailCallVal) X(TailApply)  \
+    X(Ret) X(Jmp) X(Jz)                                                 \
+    X(Add) X(Sub) X(Mul) X(Div) X(Mod)                                  \
+    X(Eq) X(Ne) X(Lt) X(Gt) X(Le) X(Ge) X(Not)                          \
+    X(AryNew) X(AryStore) X(AryLoad) X(ArySize)                         \
+    X(Map) X(Filter) X(Reduce) X(Gc)
+
+typedef enum TXN_EvalOp
+{
+#define TXN_EVAL_OP_ENUM(name) TXN_EvalOp_##name,
+    TXN_EVAL_OPS(TXN_EVAL_OP_ENUM)
+#undef TXN_EVAL_OP_ENUM
+
+    TXN_NumEvalOps
+} TXN_EvalOp;
+
+
+typedef struct TXN_EvalBuiltin
+{
+    const char* name;
+    TXN_EvalOp op;
+} TXN_EvalBuiltin;
+
+static const TXN_EvalBuiltin TXN_EvalBuiltinTable[] =
+{
+    { "+", TXN_EvalOp_Add },
+    { "-", TXN_EvalOp_Sub },
+    { "*", TXN_EvalOp_Mul },
+    { "/", TXN_EvalOp_Div },
+    { "%", TXN_EvalOp_Mod },
+    { "eq", TXN_EvalOp_Eq },
+    { "ne", TXN_EvalOp_Ne },
+    { "lt", TXN_EvalOp_Lt },
+    { "gt", TXN_EvalOp_Gt },
+    { "le", TXN_EvalOp_Le },
+    { "ge", TXN_EvalOp_Ge },
+    { "not", TXN_EvalOp_Not },
+    { "!", TXN_EvalOp_Apply },
+    { "&", TXN_EvalOp_AryNew },
+    { "&<", TXN_EvalOp_AryStore },
+    { "&>", TXN_EvalOp_AryLoad },
+    { "size", TXN_EvalOp_ArySize },
+    { "map", TXN_EvalOp_Map },
+    { "filter", TXN_EvalOp_Filter },
+    { "reduce", TXN_EvalOp_Reduce },
+    { "gc", TXN_EvalOp_Gc },
+};
+
+
+
+
+typedef vec_t(TXN_EvalVal) TXN_EvalValVec;
+
+typedef struct TXN_EvalFun
+{
+    u32 entry;
+    u32 localsTotal;
+} TXN_EvalFun;
+
+typedef vec_t(TXN_EvalFun) TXN_EvalFunVec;
+
+
+typedef struct TXN_EvalProgram
+{
+    const TXN_Space* space;
+    vec_u32 code[1];
+    vec_u32 codeNodes[1];
+    TXN_EvalValVec consts[1];
+    TXN_EvalFunVec funs[1];
+    u32 globalsTotal;
+} TXN_EvalProgram;
+
+
+void TXN_evalProgramFree(TXN_EvalProgram* prog)
+{
+    vec_free(prog->funs);
+    vec_free(prog->consts);
+    vec_free(prog->codeNodes);
+    vec_free(prog->code);
+    free(prog);
+}
+
+
+
+
+
+typedef enum TXN_EvalFunKind
+{
+    TXN_EvalFunKind_Main,
+    TXN_EvalFunKind_Def,
+    TXN_EvalFunKind_Quot,
+} TXN_EvalFunKind;
+
+typedef struct TXN_EvalPending
+{
+    u32 fun;
+    TXN_EvalFunKind kind;
+    TXN_Node node;
+} TXN_EvalPending;
+
+typedef vec_t(TXN_EvalPending) TXN_EvalPendingVec;
+
+
+typedef struct TXN_EvalLocal
+{
+    u32 sym;
+    u32 slot;
+} TXN_EvalLocal;
+
+typedef vec_t(TXN_EvalLocal) TXN_EvalLocalVec;
+
+
+// compile time bindings of one symbol, (u32)-1 where unbound
+typedef struct TXN_EvalSym
+{
+    u32 def;
+    u32 global;
+    u32 konst;
+} TXN_EvalSym;
+
+typedef vec_t(TXN_EvalSym) TXN_EvalSymVec;
+
+
+typedef struct TXN_EvalCompiler
+{
+    const TXN_Space* space;
+    TXN_EvalProgram* prog;
+    TXN_EvalSymVec syms[1];
+    TXN_EvalPendingVec pending[1];
+    TXN_EvalLocalVec locals[1];
+    TXN_EvalFunKind kind;
+    u32 depth;
+    TXN_EvalErrInfo err;
+} TXN_EvalCompiler;
+
+
+static void TXN_evalCompilerFree(TXN_EvalCompiler* c)
+{
+    vec_free(c->locals);
+    vec_free(c->pending);
+    vec_free(c->syms);
+}
+
+
+
+static bool TXN_evalCompileErr(TXN_EvalCompiler* c, TXN_EvalErr err, TXN_Node node)
+{
+    c->err.err = err;
+    c->err.node = node;
+    return false;
+}
+
+static void TXN_evalEmit(TXN_EvalCompiler* c, u32 word, TXN_Node node)
+{
+    vec_push(c->prog->code, word);
+    vec_push(c->prog->codeNodes, node.id);
+}
+
+static u32 TXN_evalFunAdd(TXN_EvalCompiler* c, TXN_EvalFunKind kind, TXN_Node node)
+{
+    u32 fun = c->prog->funs->length;
+    TXN_EvalFun f = { 0 };
+    vec_push(c->prog->funs, f);
+    TXN_EvalPending p = { fun, kind, node };
+    vec_push(c->pending, p);
+    return fun;
+}
+
+
+
+static bool TXN_evalIsIdent(const TXN_Space* space, TXN_Node node)
+{
+    return TXN_nodeIsTok(space, node) && (TXN_TokClass_Ident == TXN_tokClass(space, node));
+}
+
+static bool TXN_evalIsForm(const TXN_Space* space, TXN_Node node, const char* name)
+{
+    if (!TXN_nodeIsSeqRound(space, node) || !TXN_seqLen(space, node))
+    {
+        return false;
+    }
+    TXN_Node head = TXN_seqElm(space, node)[0];
+    return TXN_evalIsIdent(space, head) && (0 == strcmp(TXN_tokData(space, head), name));
+}
+
+static const TXN_EvalBuiltin* TXN_evalBuiltin(const char* name)
+{
+    for (u32 i = 0; i < ARYLEN(TXN_EvalBuiltinTable); ++i)
+    {
+        if (0 == strcmp(TXN_EvalBuiltinTable[i].name, name))
+        {
+            return TXN_EvalBuiltinTable + i;
+        }
+    }
+    return NULL;
+}
+
+
+
+
+static bool TXN_evalCompileNode(TXN_EvalCompiler* c, TXN_Node node, bool tail);
+
+
+// a call in tail position reuses the frame of the caller
+static bool TXN_evalCompileTok(TXN_EvalCompiler* c, TXN_Node node, bool head, bool tail)
+{
+    const TXN_Space* space = c->space;
+    TXN_EvalProgram* prog = c->prog;
+    TXN_EvalVal v = { 0 };
+    switch (TXN_tokClass(space, node))
+    {
+    case TXN_TokClass_String:
+    {
+        v.type = TXN_EvalValType_Str;
+        v.str = node;
+        TXN_evalEmit(c, TXN_EvalOp_Const, node);
+        TXN_evalEmit(c, prog->consts->length, node);
+        vec_push(prog->consts, v);
+        return true;
+    }
+    case TXN_TokClass_Int:
+    case TXN_TokClass_Float:
+    {
+        u32* k = &c->syms->data[TXN_tokSymId(space, node)].konst;
+        if (*k == (u32)-1)
+        {
+            *k = prog->consts->length;
+            if (TXN_TokClass_Int == TXN_tokClass(space, node))
+            {
+                v.type = TXN_EvalValType_Int;
+                v.i = TXN_tokAsI64(space, node);
+            }
+            else
+            {
+                v.type = TXN_EvalValType_Float;
+                v.f = TXN_tokAsF64(space, node);
+            }
+            vec_push(prog->consts, v);
+        }
+        TXN_evalEmit(c, TXN_EvalOp_Const, node);
+        TXN_evalEmit(c, *k, node);
+        return true;
+    }
+    default:
+        break;
+    }
+
+    u32 sym = TXN_tokSymId(space, node);
+    const TXN_EvalSym* bind = c->syms->data + sym;
+    for (u32 i = c->locals->length; i > 0; --i)
+    {
+        if (c->locals->data[i - 1].sym == sym)
+        {
+            TXN_evalEmit(c, TXN_EvalOp_Load, node);
+            TXN_evalEmit(c, c->locals->data[i - 1].slot, node);
+            if (head)
+            {
+                TXN_evalEmit(c, tail ? TXN_EvalOp_TailCallVal : TXN_EvalOp_CallVal, node);
+            }
+            return true;
+        }
+    }
+    if (bind->global != (u32)-1)
+    {
+        TXN_evalEmit(c, TXN_EvalOp_LoadGlobal, node);
+        TXN_evalEmit(c, bind->global, node);
+        if (head)
+        {
+            TXN_evalEmit(c, tail ? TXN_EvalOp_TailCallVal : TXN_EvalOp_CallVal, node);
+        }
+        return true;
+    }
+    if (bind->def != (u32)-1)
+    {
+        TXN_evalEmit(c, tail ? TXN_EvalOp_TailCall : TXN_EvalOp_Call, node);
+        TXN_evalEmit(c, bind->def, node);
+        return true;
+    }
+    const TXN_EvalBuiltin* builtin = TXN_evalBuiltin(TXN_tokData(space, node));
+    if (builtin)
+    {
+        TXN_evalEmit(c, (tail && (TXN_EvalOp_Apply == builtin->op)) ? TXN_EvalOp_TailApply : builtin->op, node);
+        return true;
+    }
+    return TXN_evalCompileErr(c, TXN_EvalErr_Unbound, node);
+}
+
+
+
+static bool TXN_evalCompileVar(TXN_EvalCompiler* c, TXN_Node node)
+{
+    const TXN_Space* space = c->space;
+    const TXN_Node* elms = TXN_seqElm(space, node);
+    u32 len = TXN_seqLen(space, node);
+    u32 slotsBegin = c->locals->length;
+    for (u32 i = 1; i < len; ++i)
+    {
+        if (TXN_nodeIsSeq(space, elms[i]))
+        {
+            continue;
+        }
+        if (!TXN_evalIsIdent(space, elms[i]))
+        {
+            return TXN_evalCompileErr(c, TXN_EvalErr_Syntax, elms[i]);
+        }
+        TXN_EvalLocal l = { TXN_tokSymId(space, elms[i]), i };
+        vec_push(c->locals, l);
+    }
+
+    TXN_EvalOp op = TXN_EvalOp_Store;
+    if (TXN_EvalFunKind_Main == c->kind)
+    {
+        op = TXN_EvalOp_StoreGlobal;
+        for (u32 i = slotsBegin; i < c->locals->length; ++i)
+        {
+            TXN_EvalLocal* l = c->locals->data + i;
+            u32* global = &c->syms->data[l->sym].global;
+            if (*global == (u32)-1)
+            {
+                *global = c->prog->globalsTotal++;
+            }
+            l->slot = *global;
+        }
+    }
+    else
+    {
+        for (u32 i = slotsBegin; i < c->locals->length; ++i)
+        {
+            c->locals->data[i].slot = i;
+        }
+    }
+    for (u32 i = c->locals->length; i > slotsBegin; --i)
+    {
+        TXN_evalEmit(c, op, node);
+        TXN_evalEmit(c, c->locals->data[i - 1].slot, node);
+    }
+    if (TXN_EvalFunKind_Main == c->kind)
+    {
+        vec_resize(c->locals, slotsBegin);
+    }
+    return true;
+}
+
+
+static bool TXN_evalCompileIf(TXN_EvalCompiler* c, TXN_Node node, bool tail)
+{
+    const TXN_Space* space = c->space;
+    const TXN_Node* elms = TXN_seqElm(space, node);
+    u32 len = TXN_seqLen(space, node);
+    if ((len != 3) && (len != 4))
+    {
+        return TXN_evalCompileErr(c, TXN_EvalErr_Syntax, node);
+    }
+    vec_u32* code = c->prog->code;
+    if (!TXN_evalCompileNode(c, elms[1], false))
+    {
+        return false;
+    }
+    TXN_evalEmit(c, TXN_EvalOp_Jz, node);
+    u32 jz = code->length;
+    TXN_evalEmit(c, 0, node);
+    if (!TXN_evalCompileNode(c, elms[2], tail))
+    {
+        return false;
+    }
+    if (3 == len)
+    {
+        code->data[jz] = code->length;
+        return true;
+    }
+    if (tail)
+    {
+        TXN_evalEmit(c, TXN_EvalOp_Ret, node);
+        code->data[jz] = code->length;
+        return TXN_evalCompileNode(c, elms[3], tail);
+    }
+    TXN_evalEmit(c, TXN_EvalOp_Jmp, node);
+    u32 jmp = code->length;
+    TXN_evalEmit(c, 0, node);
+    code->data[jz] = code->length;
+    if (!TXN_evalCompileNode(c, elms[3], tail))
+    {
+        return false;
+    }
+    code->data[jmp] = code->length;
+    return true;
+}
+
+
+static bool TXN_evalCompileForm(TXN_EvalCompiler* c, TXN_Node node, bool tail)
+{
+    const TXN_Space* space = c->space;
+    const TXN_Node* elms = TXN_seqElm(space, node);
+    u32 len = TXN_seqLen(space, node);
+    if (!len)
+    {
+        return true;
+    }
+    TXN_Node head = elms[0];
+    if (TXN_evalIsIdent(space, head))
+    {
+        const char* name = TXN_tokData(space, head);
+        if (0 == strcmp(name, "def"))
+        {
+            return TXN_evalCompileErr(c, TXN_EvalErr_Syntax, node);
+        }
+        if (0 == strcmp(name, "var"))
+        {
+            return TXN_evalCompileVar(c, node);
+        }
+        if (0 == strcmp(name, "if"))
+        {
+            return TXN_evalCompileIf(c, node, tail);
+        }
+    }
+    for (u32 i = 1; i < len; ++i)
+    {
+        if (!TXN_evalCompileNode(c, elms[i], false))
+        {
+            return false;
+        }
+    }
+    if (TXN_nodeIsTok(space, head))
+    {
+        return TXN_evalCompileTok(c, head, true, tail);
+    }
+    return TXN_evalCompileNode(c, head, tail);
+}
+
+
+static bool TXN_evalCompileNested(TXN_EvalCompiler* c, TXN_Node node, bool tail)
+{
+    const TXN_Space* space = c->space;
+    switch (TXN_nodeType(space, node))
+    {
+    case TXN_NodeType_Tok:
+        return TXN_evalCompileTok(c, node, false, tail);
+    case TXN_NodeType_SeqRound:
+        return TXN_evalCompileForm(c, node, tail);
+    case TXN_NodeType_SeqSquare:
+    {
+        u32 fun = TXN_evalFunAdd(c, TXN_EvalFunKind_Quot, node);
+        TXN_evalEmit(c, TXN_EvalOp_Quot, node);
+        TXN_evalEmit(c, fun, node);
+        return true;
+    }
+    default:
+    {
+        const TXN_Node* elms = TXN_seqElm(space, node);
+        u32 len = TXN_seqLen(space, node);
+        for (u32 i = 0; i < len; ++i)
+        {
+            if (!TXN_evalCompileNode(c, elms[i], tail && (i + 1 == len)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    }
+}
+
+// forms compile recursively, so nesting is capped to keep the native stack bounded
+static bool TXN_evalCompileNode(TXN_EvalCompiler* c, TXN_Node node, bool tail)
+{
+    if (c->depth >= TXN_EvalCompileDepth_Max)
+    {
+        return TXN_evalCompileErr(c, TXN_EvalErr_Syntax, node);
+    }
+    ++c->depth;
+    bool ok = TXN_evalCompileNested(c, node, tail);
+    --c->depth;
+    return ok;
+}
+
+
+static bool TXN_evalCompileFun(TXN_EvalCompiler* c, const TXN_EvalPending* p)
+{
+    const TXN_Space* space = c->space;
+    TXN_EvalProgram* prog = c->prog;
+    const TXN_Node* elms = TXN_seqElm(space, p->node);
+    u32 len = TXN_seqLen(space, p->node);
+    u32 begin = (TXN_EvalFunKind_Def == p->kind) ? 2 : 0;
+
+    c->kind = p->kind;
+    vec_clear(c->locals);
+    prog->funs->data[p->fun].entry = prog->code->length;
+    for (u32 i = begin; i < len; ++i)
+    {
+        if ((TXN_EvalFunKind_Main == p->kind) && TXN_evalIsForm(space, elms[i], "def"))
+        {
+            continue;
+        }
+        if (!TXN_evalCompileNode(c, elms[i], i + 1 == len))
+        {
+            return false;
+        }
+    }
+    TXN_evalEmit(c, TXN_EvalOp_Ret, p->node);
+    prog->funs->data[p->fun].localsTotal = c->locals->length;
+    return true;
+}
+
+
+
+
+TXN_EvalProgram* TXN_evalCompile(const TXN_Space* space, TXN_Node root, TXN_EvalErrInfo* err)
+{
+    assert(TXN_nodeIsSeq(space, root));
+    TXN_EvalProgram* prog = zalloc(sizeof(*prog));
+    prog->space = space;
+
+    TXN_EvalCompiler c[1] = { 0 };
+    c->space = space;
+    c->prog = prog;
+    c->err.node = TXN_Node_Invalid;
+    if (TXN_spaceSymsTotal(space))
+    {
+        vec_resize(c->syms, TXN_spaceSymsTotal(space));
+        memset(c->syms->data, 0xff, sizeof(TXN_EvalSym)*c->syms->length);
+    }
+
+    TXN_evalFunAdd(c, TXN_EvalFunKind_Main, root);
+    const TXN_Node* elms = TXN_seqElm(space, root);
+    for (u32 i = 0; i < TXN_seqLen(space, root); ++i)
+    {
+        if (!TXN_evalIsForm(space, elms[i], "def"))
+        {
+            continue;
+        }
+        const TXN_Node* def = TXN_seqElm(space, elms[i]);
+        if ((TXN_seqLen(space, elms[i]) < 2) || !TXN_evalIsIdent(space, def[1]))
+        {
+            TXN_evalCompileErr(c, TXN_EvalErr_Syntax, elms[i]);
+            goto failed;
+        }
+        u32* fun = &c->syms->data[TXN_tokSymId(space, def[1])].def;
+        if (*fun != (u32)-1)
+        {
+            TXN_evalCompileErr(c, TXN_EvalErr_Syntax, elms[i]);
+            goto failed;
+        }
+        *fun = TXN_evalFunAdd(c, TXN_EvalFunKind_Def, elms[i]);
+    }
+
+    for (u32 i = 0; i < c->pending->length; ++i)
+    {
+        TXN_EvalPending p = c->pending->data[i];
+        if (!TXN_evalCompileFun(c, &p))
+        {
+            goto failed;
+        }
+    }
+    if (err)
+    {
+        *err = c->err;
+    }
+    TXN_evalCompilerFree(c);
+    return prog;
+failed:
+    if (err)
+    {
+        *err = c->err;
+    }
+    TXN_evalCompilerFree(c);
+    TXN_evalProgramFree(prog);
+    return NULL;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+typedef struct TXN_EvalFrame
+{
+    u32 retPc;
+    u32 localsBase;
+} TXN_EvalFrame;
+
+typedef vec_t(TXN_EvalFrame) TXN_EvalFrameVec;
+
+
+typedef enum TXN_EvalAryType
+{
+    TXN_EvalAryType_Int,
+    TXN_EvalAryType_Float,
+    TXN_EvalAryType_Val,
+} TXN_EvalAryType;
+
+// numbers are stored unboxed and contiguous, a store that does not fit widens the whole array
+typedef struct TXN_EvalAry
+{
+    TXN_EvalAryType type;
+    u32 length;
+    // slots allocated for the elements, a map fills them one by one from length 0
+    u32 capacity;
+    u32 forward;
+    union
+    {
+        s64* i;
+        f64* f;
+        TXN_EvalVal* v;
+    };
+} TXN_EvalAry;
+
+typedef vec_t(TXN_EvalAry*) TXN_EvalAryVec;
+
+
+
+
+enum
+{
+    TXN_EvalArenaChunk_Size = 64 * 1024,
+};
+
+typedef vec_t(u8*) TXN_EvalChunkVec;
+
+// bump allocator, everything in it is freed at once
+typedef struct TXN_EvalArena
+{
+    TXN_EvalChunkVec chunks[1];
+    u8* cur;
+    size_t left;
+    u64 size;
+} TXN_EvalArena;
+
+
+static void* TXN_evalArenaAlloc(TXN_EvalArena* arena, size_t size)
+{
+    size = (size + 15) & ~(size_t)15;
+    if (size > arena->left)
+    {
+        // big blocks get a chunk of their own and keep the current one going
+        if (size > TXN_EvalArenaChunk_Size / 4)
+        {
+            u8* p = malloc(size);
+            vec_push(arena->chunks, p);
+            arena->size += size;
+            return p;
+        }
+        arena->cur = malloc(TXN_EvalArenaChunk_Size);
+        arena->left = TXN_EvalArenaChunk_Size;
+        vec_push(arena->chunks, arena->cur);
+        arena->size += TXN_EvalArenaChunk_Size;
+    }
+    void* p = arena->cur;
+    arena->cur += size;
+    arena->left -= size;
+    return p;
+}
+
+static void TXN_evalArenaFree(TXN_EvalArena* arena)
+{
+    for (u32 i = 0; i < arena->chunks->length; ++i)
+    {
+        free(arena->chunks->data[i]);
+    }
+    vec_free(arena->chunks);
+    arena->cur = NULL;
+    arena->left = 0;
+    arena->size = 0;
+}
+
+
+typedef struct TXN_EvalVM
+{
+    const TXN_EvalProgram* prog;
+    TXN_EvalValVec stack[1];
+    TXN_EvalValVec locals[1];
+    TXN_EvalValVec globals[1];
+    TXN_EvalFrameVec frames[1];
+    TXN_EvalAryVec arys[1];
+    TXN_EvalArena arena[1];
+    u32 applyDepth;
+    TXN_EvalErrInfo err;
+} TXN_EvalVM;
+
+
+static size_t TXN_evalAryBytes(TXN_EvalAryType type, u32 len)
+{
+    return (size_t)len * ((TXN_EvalAryType_Val == type) ? sizeof(TXN_EvalVal) : sizeof(s64));
+}
+
+static TXN_EvalAry* TXN_evalAryNew(TXN_EvalVM* vm, TXN_EvalAryType type, u32 len, TXN_EvalVal* out)
+{
+    TXN_EvalAry* a = TXN_evalArenaAlloc(vm->arena, sizeof(*a));
+    a->type = type;
+    a->length = len;
+    a->capacity = len;
+    a->forward = (u32)-1;
+    a->v = TXN_evalArenaAlloc(vm->arena, TXN_evalAryBytes(type, len));
+    out->type = TXN_EvalValType_Ary;
+    out->ary = vm->arys->length;
+    vec_push(vm->arys, a);
+    return a;
+}
+
+static TXN_EvalVal TXN_evalAryGet(const TXN_EvalAry* a, u32 i)
+{
+    TXN_EvalVal v = { TXN_EvalValType_Int };
+    switch (a->type)
+    {
+    case TXN_EvalAryType_Int:
+        v.i = a->i[i];
+        return v;
+    case TXN_EvalAryType_Float:
+        v.type = TXN_EvalValType_Float;
+        v.f = a->f[i];
+        return v;
+    default:
+        return a->v[i];
+    }
+}
+
+
+
+
+TXN_EvalVM* TXN_evalVmNew(const TXN_EvalProgram* prog)
+{
+    TXN_EvalVM* vm = zalloc(sizeof(*vm));
+    vm->prog = prog;
+    if (prog->globalsTotal)
+    {
+        vec_resize(vm->globals, prog->globalsTotal);
+        memset(vm->globals->data, 0, sizeof(TXN_EvalVal)*prog->globalsTotal);
+    }
+    vm->err.node = TXN_Node_Invalid;
+    return vm;
+}
+
+void TXN_evalVmFree(TXN_EvalVM* vm)
+{
+    TXN_evalArenaFree(vm->arena);
+    vec_free(vm->arys);
+    vec_free(vm->frames);
+    vec_free(vm->globals);
+    vec_free(vm->locals);
+    vec_free(vm->stack);
+    free(vm);
+}
+
+
+
+TXN_EvalErrInfo TXN_evalVmErr(const TXN_EvalVM* vm)
+{
+    return vm->err;
+}
+
+u32 TXN_evalStackTotal(const TXN_EvalVM* vm)
+{
+    return vm->stack->length;
+}
+
+const TXN_EvalVal* TXN_evalStack(const TXN_EvalVM* vm)
+{
+    return vm->stack->data;
+}
+
+void TXN_evalStackClear(TXN_EvalVM* vm)
+{
+    vec_clear(vm->stack);
+}
+
+
+
+u32 TXN_evalAryLen(const TXN_EvalVM* vm, TXN_EvalVal ary)
+{
+    assert(TXN_EvalValType_Ary == ary.type);
+    return vm->arys->data[ary.ary]->length;
+}
+
+TXN_EvalVal TXN_evalAryElm(const TXN_EvalVM* vm, TXN_EvalVal ary, u32 i)
+{
+    assert(TXN_EvalValType_Ary == ary.type);
+    assert(i < TXN_evalAryLen(vm, ary));
+    return TXN_evalAryGet(vm->arys->data[ary.ary], i);
+}
+
+
+
+
+
+static bool TXN_evalTruthy(const TXN_EvalVal* v)
+{
+    switch (v->type)
+    {
+    case TXN_EvalValType_Int:
+        return v->i != 0;
+    case TXN_EvalValType_Float:
+        return v->f != 0;
+    default:
+        return true;
+    }
+}
+
+static bool TXN_evalIsNum(const TXN_EvalVal* v)
+{
+    return (TXN_EvalValType_Int == v->type) || (TXN_EvalValType_Float == v->type);
+}
+
+static f64 TXN_evalAsF64(const TXN_EvalVal* v)
+{
+    return (TXN_EvalValType_Int == v->type) ? (f64)v->i : v->f;
+}
+
+static bool TXN_evalValEq(const TXN_Space* space, const TXN_EvalVal* a, const TXN_EvalVal* b)
+{
+    if (TXN_evalIsNum(a) && TXN_evalIsNum(b))
+    {
+        if ((TXN_EvalValType_Int == a->type) && (TXN_EvalValType_Int == b->type))
+        {
+            return a->i == b->i;
+        }
+        return TXN_evalAsF64(a) == TXN_evalAsF64(b);
+    }
+    if (a->type != b->type)
+    {
+        return false;
+    }
+    switch (a->type)
+    {
+    case TXN_EvalValType_Str:
+        return TXN_tokSymId(space, a->str) == TXN_tokSymId(space, b->str);
+    case TXN_EvalValType_Quot:
+        return a->quot == b->quot;
+    case TXN_EvalValType_Ary:
+        return a->ary == b->ary;
+    default:
+        assert(false);
+        return false;
+    }
+}
+
+
+// a = a op b, comparisons give int 0/1
+static TXN_EvalErr TXN_evalBinOp(const TXN_Space* space, TXN_EvalOp op, TXN_EvalVal* a, const TXN_EvalVal* b)
+{
+    if ((TXN_EvalValType_Int == a->type) && (TXN_EvalValType_Int == b->type))
+    {
+        s64 x = a->i, y = b->i;
+        switch (op)
+        {
+        case TXN_EvalOp_Add: a->i = (s64)((u64)x + (u64)y); return TXN_EvalErr_None;
+        case TXN_EvalOp_Sub: a->i = (s64)((u64)x - (u64)y); return TXN_EvalErr_None;
+        case TXN_EvalOp_Mul: a->i = (s64)((u64)x * (u64)y); return TXN_EvalErr_None;
+        case TXN_EvalOp_Div:
+        case TXN_EvalOp_Mod:
+            if (!y)
+            {
+                return TXN_EvalErr_DivZero;
+            }
+            if (-1 == y)
+            {
+                a->i = (TXN_EvalOp_Div == op) ? (s64)(0 - (u64)x) : 0;
+                return TXN_EvalErr_None;
+            }
+            a->i = (TXN_EvalOp_Div == op) ? (x / y) : (x % y);
+            return TXN_EvalErr_None;
+        case TXN_EvalOp_Eq: a->i = x == y; return TXN_EvalErr_None;
+        case TXN_EvalOp_Ne: a->i = x != y; return TXN_EvalErr_None;
+        case TXN_EvalOp_Lt: a->i = x < y; return TXN_EvalErr_None;
+        case TXN_EvalOp_Gt: a->i = x > y; return TXN_EvalErr_None;
+        case TXN_EvalOp_Le: a->i = x <= y; return TXN_EvalErr_None;
+        case TXN_EvalOp_Ge: a->i = x >= y; return TXN_EvalErr_None;
+        default:
+            assert(false);
+            return TXN_EvalErr_Type;
+        }
+    }
+    if ((TXN_EvalOp_Eq == op) || (TXN_EvalOp_Ne == op))
+    {
+        bool eq = TXN_evalValEq(space, a, b);
+        a->type = TXN_EvalValType_Int;
+        a->i = (TXN_EvalOp_Eq == op) ? eq : !eq;
+        return TXN_EvalErr_None;
+    }
+    if (!TXN_evalIsNum(a) || !TXN_evalIsNum(b))
+    {
+        return TXN_EvalErr_Type;
+    }
+    f64 x = TXN_evalAsF64(a), y = TXN_evalAsF64(b);
+    a->type = TXN_EvalValType_Float;
+    switch (op)
+    {
+    case TXN_EvalOp_Add: a->f = x + y; return TXN_EvalErr_None;
+    case TXN_EvalOp_Sub: a->f = x - y; return TXN_EvalErr_None;
+    case TXN_EvalOp_Mul: a->f = x * y; return TXN_EvalErr_None;
+    case TXN_EvalOp_Div: a->f = x / y; return TXN_EvalErr_None;
+    case TXN_EvalOp_Mod: a->f = fmod(x, y); return TXN_EvalErr_None;
+    default:
+        break;
+    }
+    a->type = TXN_EvalValType_Int;
+    switch (op)
+    {
+    case TXN_EvalOp_Lt: a->i = x < y; return TXN_EvalErr_None;
+    case TXN_EvalOp_Gt: a->i = x > y; return TXN_EvalErr_None;
+    case TXN_EvalOp_Le: a->i = x <= y; return TXN_EvalErr_None;
+    case TXN_EvalOp_Ge: a->i = x >= y; return TXN_EvalErr_None;
+    default:
+        assert(false);
+        return TXN_EvalErr_Type;
+    }
+}
+
+
+
+
+static bool TXN_evalExec(TXN_EvalVM* vm, u32 fun);
+
+
+static void TXN_evalAryWiden(TXN_EvalVM* vm, TXN_EvalAry* a, TXN_EvalAryType type)
+{
+    assert(type > a->type);
+    if (TXN_EvalAryType_Float == type)
+    {
+        for (u32 i = 0; i < a->length; ++i)
+        {
+            s64 x = a->i[i];
+            a->f[i] = (f64)x;
+        }
+    }
+    else
+    {
+        TXN_EvalVal* v = TXN_evalArenaAlloc(vm->arena, TXN_evalAryBytes(type, a->capacity));
+        for (u32 i = 0; i < a->length; ++i)
+        {
+            v[i] = TXN_evalAryGet(a, i);
+        }
+        a->v = v;
+    }
+    a->type = type;
+}
+
+static void TXN_evalArySet(TXN_EvalVM* vm, TXN_EvalAry* a, u32 i, const TXN_EvalVal* v)
+{
+    TXN_EvalAryType type = TXN_EvalAryType_Val;
+    if (TXN_EvalValType_Int == v->type)
+    {
+        type = TXN_EvalAryType_Int;
+    }
+    else if (TXN_EvalValType_Float == v->type)
+    {
+        type = TXN_EvalAryType_Float;
+    }
+    if (type > a->type)
+    {
+        TXN_evalAryWiden(vm, a, type);
+    }
+    switch (a->type)
+    {
+    case TXN_EvalAryType_Int:
+        a->i[i] = v->i;
+        break;
+    case TXN_EvalAryType_Float:
+        a->f[i] = TXN_evalAsF64(v);
+        break;
+    default:
+        a->v[i] = *v;
+        break;
+    }
+}
+
+
+
+
+static bool TXN_evalIsBinOp(u32 op)
+{
+    return (TXN_EvalOp_Add <= op) && (op <= TXN_EvalOp_Ge);
+}
+
+static bool TXN_evalIsCmpOp(u32 op)
+{
+    return (TXN_EvalOp_Eq <= op) && (op <= TXN_EvalOp_Ge);
+}
+
+// recognizes quotations of the form [c op] and [op], c is NULL for the latter
+static bool TXN_evalQuotShape(const TXN_EvalProgram* prog, u32 fun, TXN_EvalOp* op, const TXN_EvalVal** c)
+{
+    const u32* code = prog->code->data + prog->funs->data[fun].entry;
+    if ((TXN_EvalOp_Const == code[0]) && TXN_evalIsBinOp(code[2]) && (TXN_EvalOp_Ret == code[3]))
+    {
+        *op = (TXN_EvalOp)code[2];
+        *c = prog->consts->data + code[1];
+        return TXN_evalIsNum(*c);
+    }
+    if (TXN_evalIsBinOp(code[0]) && (TXN_EvalOp_Ret == code[1]))
+    {
+        *op = (TXN_EvalOp)code[0];
+        *c = NULL;
+        return true;
+    }
+    return false;
+}
+
+
+
+// the kernels below are plain loops over unboxed storage written for the auto-vectorizer
+
+static void TXN_evalMapI64(TXN_EvalOp op, const s64* TXN_RESTRICT x, s64 y, s64* TXN_RESTRICT r, u32 n)
+{
+    switch (op)
+    {
+    case TXN_EvalOp_Add: for (u32 i = 0; i < n; ++i) r[i] = (s64)((u64)x[i] + (u64)y); break;
+    case TXN_EvalOp_Sub: for (u32 i = 0; i < n; ++i) r[i] = (s64)((u64)x[i] - (u64)y); break;
+    case TXN_EvalOp_Mul: for (u32 i = 0; i < n; ++i) r[i] = (s64)((u64)x[i] * (u64)y); break;
+    case TXN_EvalOp_Div: for (u32 i = 0; i < n; ++i) r[i] = x[i] / y; break;
+    case TXN_EvalOp_Mod: for (u32 i = 0; i < n; ++i) r[i] = x[i] % y; break;
+    case TXN_EvalOp_Eq: for (u32 i = 0; i < n; ++i) r[i] = x[i] == y; break;
+    case TXN_EvalOp_Ne: for (u32 i = 0; i < n; ++i) r[i] = x[i] != y; break;
+    case TXN_EvalOp_Lt: for (u32 i = 0; i < n; ++i) r[i] = x[i] < y; break;
+    case TXN_EvalOp_Gt: for (u32 i = 0; i < n; ++i) r[i] = x[i] > y; break;
+    case TXN_EvalOp_Le: for (u32 i = 0; i < n; ++i) r[i] = x[i] <= y; break;
+    case TXN_EvalOp_Ge: for (u32 i = 0; i < n; ++i) r[i] = x[i] >= y; break;
+    default:
+        assert(false);
+        break;
+    }
+}
+
+static void TXN_evalMapF64(TXN_EvalOp op, const f64* TXN_RESTRICT x, f64 y, void* TXN_RESTRICT out, u32 n)
+{
+    f64* r = out;
+    s64* b = out;
+    switch (op)
+    {
+    case TXN_EvalOp_Add: for (u32 i = 0; i < n; ++i) r[i] = x[i] + y; break;
+    case TXN_EvalOp_Sub: for (u32 i = 0; i < n; ++i) r[i] = x[i] - y; break;
+    case TXN_EvalOp_Mul: for (u32 i = 0; i < n; ++i) r[i] = x[i] * y; break;
+    case TXN_EvalOp_Div: for (u32 i = 0; i < n; ++i) r[i] = x[i] / y; break;
+    case TXN_EvalOp_Mod: for (u32 i = 0; i < n; ++i) r[i] = fmod(x[i], y); break;
+    case TXN_EvalOp_Eq: for (u32 i = 0; i < n; ++i) b[i] = x[i] == y; break;
+    case TXN_EvalOp_Ne: for (u32 i = 0; i < n; ++i) b[i] = x[i] != y; break;
+    case TXN_EvalOp_Lt: for (u32 i = 0; i < n; ++i) b[i] = x[i] < y; break;
+    case TXN_EvalOp_Gt: for (u32 i = 0; i < n; ++i) b[i] = x[i] > y; break;
+    case TXN_EvalOp_Le: for (u32 i = 0; i < n; ++i) b[i] = x[i] <= y; break;
+    case TXN_EvalOp_Ge: for (u32 i = 0; i < n; ++i) b[i] = x[i] >= y; break;
+    default:
+        assert(false);
+        break;
+    }
+}
+
+
+// keeps x[i] where x[i] op y, branch-free so it does not depend on the data
+#define TXN_EVAL_FILTER(T, X)                                                               \
+    static u32 TXN_evalFilter##X(TXN_EvalOp op, const T* TXN_RESTRICT x, T y, T* TXN_RESTRICT r, u32 n) \
+    {                                                                                       \
+        u32 k = 0;                                                                          \
+        switch (op)                                                                         \
+        {                                                                                   \
+        case TXN_EvalOp_Eq: for (u32 i = 0; i < n; ++i) { r[k] = x[i]; k += x[i] == y; } break; \
+        case TXN_EvalOp_Ne: for (u32 i = 0; i < n; ++i) { r[k] = x[i]; k += x[i] != y; } break; \
+        case TXN_EvalOp_Lt: for (u32 i = 0; i < n; ++i) { r[k] = x[i]; k += x[i] < y; } break;  \
+        case TXN_EvalOp_Gt: for (u32 i = 0; i < n; ++i) { r[k] = x[i]; k += x[i] > y; } break;  \
+        case TXN_EvalOp_Le: for (u32 i = 0; i < n; ++i) { r[k] = x[i]; k += x[i] <= y; } break; \
+        case TXN_EvalOp_Ge: for (u32 i = 0; i < n; ++i) { r[k] = x[i]; k += x[i] >= y; } break; \
+        default: assert(false); break;                                                      \
+        }                                                                                   \
+        return k;                                                                           \
+    }
+
+TXN_EVAL_FILTER(s64, I64)
+TXN_EVAL_FILTER(f64, F64)
+
+#undef TXN_EVAL_FILTER
+
+
+static s64 TXN_evalSumI64(const s64* x, u32 n)
+{
+    u64 sum = 0;
+    for (u32 i = 0; i < n; ++i)
+    {
+        sum += (u64)x[i];
+    }
+    return (s64)sum;
+}
+
+// sums in two lanes, so the rounding can differ from a left fold in the last bits
+static f64 TXN_evalSumF64(const f64* x, u32 n)
+{
+    u32 i = 0;
+#ifdef TXN_USE_SSE2
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(x + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(x + i + 2));
+    }
+    acc0 = _mm_add_pd(acc0, acc1);
+    f64 lanes[2];
+    _mm_storeu_pd(lanes, acc0);
+    f64 sum = lanes[0] + lanes[1];
+#else
+    f64 sum = 0;
+#endif
+    for (; i < n; ++i)
+    {
+        sum += x[i];
+    }
+    return sum;
+}
+
+
+
+
+// runs a map, filter or reduce without calling fun, false if it has no kernel for this shape
+static bool TXN_evalAryKernel(TXN_EvalVM* vm, TXN_EvalOp op, TXN_EvalVal ary, u32 fun)
+{
+    TXN_EvalOp bin;
+    const TXN_EvalVal* c;
+    TXN_EvalAry* a = vm->arys->data[ary.ary];
+    if ((TXN_EvalAryType_Val == a->type) || !TXN_evalQuotShape(vm->prog, fun, &bin, &c))
+    {
+        return false;
+    }
+    u32 n = a->length;
+    TXN_EvalVal out = { TXN_EvalValType_Int };
+
+    if (TXN_EvalOp_Reduce == op)
+    {
+        if (c || (TXN_EvalOp_Add != bin) || !n)
+        {
+            return false;
+        }
+        if (TXN_EvalAryType_Int == a->type)
+        {
+            out.i = TXN_evalSumI64(a->i, n);
+        }
+        else
+        {
+            out.type = TXN_EvalValType_Float;
+            out.f = TXN_evalSumF64(a->f, n);
+        }
+        vec_push(vm->stack, out);
+        return true;
+    }
+    if (!c)
+    {
+        return false;
+    }
+
+    if ((TXN_EvalAryType_Int == a->type) && (TXN_EvalValType_Int == c->type))
+    {
+        if (TXN_EvalOp_Filter == op)
+        {
+            if (!TXN_evalIsCmpOp(bin))
+            {
+                return false;
+            }
+            TXN_EvalAry* b = TXN_evalAryNew(vm, TXN_EvalAryType_Int, n, &out);
+            b->length = TXN_evalFilterI64(bin, a->i, c->i, b->i, n);
+        }
+        else
+        {
+            // zero and -1 divisors take the generic path for its error and overflow handling
+            if (((TXN_EvalOp_Div == bin) || (TXN_EvalOp_Mod == bin)) && ((0 == c->i) || (-1 == c->i)))
+            {
+                return false;
+            }
+            TXN_EvalAry* b = TXN_evalAryNew(vm, TXN_EvalAryType_Int, n, &out);
+            TXN_evalMapI64(bin, a->i, c->i, b->i, n);
+        }
+        vec_push(vm->stack, out);
+        return true;
+    }
+
+    if ((TXN_EvalOp_Filter == op) && !TXN_evalIsCmpOp(bin))
+    {
+        return false;
+    }
+    const f64* x = a->f;
+    f64* tmp = NULL;
+    if (TXN_EvalAryType_Int == a->type)
+    {
+        tmp = malloc(max(n, 1) * sizeof(f64));
+        for (u32 i = 0; i < n; ++i)
+        {
+            tmp[i] = (f64)a->i[i];
+        }
+        x = tmp;
+    }
+    f64 y = TXN_evalAsF64(c);
+    if (TXN_EvalOp_Filter == op)
+    {
+        // keeps the elements as stored, an int array stays int
+        TXN_EvalAry* b = TXN_evalAryNew(vm, a->type, n, &out);
+        if (tmp)
+        {
+            u32 k = 0;
+            for (u32 i = 0; i < n; ++i)
+            {
+                f64 xi = x[i];
+                b->i[k] = a->i[i];
+                switch (bin)
+                {
+                case TXN_EvalOp_Eq: k += xi == y; break;
+                case TXN_EvalOp_Ne: k += xi != y; break;
+                case TXN_EvalOp_Lt: k += xi < y; break;
+                case TXN_EvalOp_Gt: k += xi > y; break;
+                case TXN_EvalOp_Le: k += xi <= y; break;
+                default: k += xi >= y; break;
+                }
+            }
+            b->length = k;
+        }
+        else
+        {
+            b->length = TXN_evalFilterF64(bin, x, y, b->f, n);
+        }
+    }
+    else
+    {
+        TXN_EvalAryType type = TXN_evalIsCmpOp(bin) ? TXN_EvalAryType_Int : TXN_EvalAryType_Float;
+        TXN_EvalAry* b = TXN_evalAryNew(vm, type, n, &out);
+        TXN_evalMapF64(bin, x, y, b->v, n);
+    }
+    free(tmp);
+    vec_push(vm->stack, out);
+    return true;
+}
+
+
+
+
+// applies fun to every element of ary, op is Map, Filter or Reduce
+static TXN_EvalErr TXN_evalAryApply(TXN_EvalVM* vm, TXN_EvalOp op, TXN_EvalVal ary, u32 fun)
+{
+    if (TXN_evalAryKernel(vm, op, ary, fun))
+    {
+        return TXN_EvalErr_None;
+    }
+
+    TXN_EvalValVec* stack = vm->stack;
+    u32 len = vm->arys->data[ary.ary]->length;
+    TXN_EvalErr err = TXN_EvalErr_None;
+    ++vm->applyDepth;
+    if (TXN_EvalOp_Reduce == op)
+    {
+        TXN_EvalVal acc = { TXN_EvalValType_Int };
+        if (len)
+        {
+            acc = TXN_evalAryGet(vm->arys->data[ary.ary], 0);
+        }
+        for (u32 i = 1; i < len; ++i)
+        {
+            u32 base = stack->length;
+            vec_push(stack, acc);
+            TXN_EvalVal elm = TXN_evalAryGet(vm->arys->data[ary.ary], i);
+            vec_push(stack, elm);
+            if (!TXN_evalExec(vm, fun))
+            {
+                err = vm->err.err;
+                goto out;
+            }
+            if (stack->length < base + 1)
+            {
+                err = TXN_EvalErr_StackUnderflow;
+                goto out;
+            }
+            acc = vec_pop(stack);
+        }
+        vec_push(stack, acc);
+        goto out;
+    }
+
+    TXN_EvalVal res;
+    TXN_EvalAryType type = (TXN_EvalOp_Map == op) ? TXN_EvalAryType_Int : vm->arys->data[ary.ary]->type;
+    TXN_EvalAry* dst = TXN_evalAryNew(vm, type, len, &res);
+    dst->length = 0;
+    for (u32 i = 0; i < len; ++i)
+    {
+        u32 base = stack->length;
+        TXN_EvalVal elm = TXN_evalAryGet(vm->arys->data[ary.ary], i);
+        vec_push(stack, elm);
+        if (!TXN_evalExec(vm, fun))
+        {
+            err = vm->err.err;
+            goto out;
+        }
+        if (stack->length < base + 1)
+        {
+            err = TXN_EvalErr_StackUnderflow;
+            goto out;
+        }
+        TXN_EvalVal r = vec_pop(stack);
+        if (TXN_EvalOp_Map == op)
+        {
+            TXN_evalArySet(vm, dst, dst->length++, &r);
+        }
+        else if (TXN_evalTruthy(&r))
+        {
+            TXN_evalArySet(vm, dst, dst->length++, &elm);
+        }
+    }
+    vec_push(stack, res);
+out:
+    --vm->applyDepth;
+    return err;
+}
+
+
+
+
+static void TXN_evalGcMove(TXN_EvalVM* vm, const TXN_EvalAryVec* from, TXN_EvalVal* v)
+{
+    if (TXN_EvalValType_Ary != v->type)
+    {
+        return;
+    }
+    TXN_EvalAry* a = from->data[v->ary];
+    if ((u32)-1 == a->forward)
+    {
+        TXN_EvalAry* b = TXN_evalArenaAlloc(vm->arena, sizeof(*b));
+        *b = *a;
+        b->capacity = a->length;
+        size_t bytes = TXN_evalAryBytes(a->type, a->length);
+        b->v = TXN_evalArenaAlloc(vm->arena, bytes);
+        if (bytes)
+        {
+            memcpy(b->v, a->v, bytes);
+        }
+        a->forward = vm->arys->length;
+        vec_push(vm->arys, b);
+    }
+    v->ary = a->forward;
+}
+
+
+// copies what vars, locals and the stack reach into a new arena and drops the old one whole,
+// the cost follows the live data not what was allocated since the last gc
+void TXN_evalGc(TXN_EvalVM* vm)
+{
+    assert(!vm->applyDepth);
+    TXN_EvalArena from = *vm->arena;
+    TXN_EvalAryVec fromArys = *vm->arys;
+    memset(vm->arena, 0, sizeof(vm->arena));
+    memset(vm->arys, 0, sizeof(vm->arys));
+
+    TXN_EvalValVec* roots[] = { vm->globals, vm->locals, vm->stack };
+    for (u32 r = 0; r < ARYLEN(roots); ++r)
+    {
+        for (u32 i = 0; i < roots[r]->length; ++i)
+        {
+            TXN_evalGcMove(vm, &fromArys, roots[r]->data + i);
+        }
+    }
+    for (u32 i = 0; i < vm->arys->length; ++i)
+    {
+        TXN_EvalAry* a = vm->arys->data[i];
+        if (TXN_EvalAryType_Val != a->type)
+        {
+            continue;
+        }
+        for (u32 j = 0; j < a->length; ++j)
+        {
+            TXN_evalGcMove(vm, &fromArys, a->v + j);
+        }
+    }
+
+    TXN_evalArenaFree(&from);
+    vec_free(&fromArys);
+}
+
+u64 TXN_evalHeapSize(const TXN_EvalVM* vm)
+{
+    return vm->arena->size;
+}
+
+
+
+
+// grows geometrically since every call resizes, new slots read as int 0
+static void TXN_evalLocalsResize(TXN_EvalValVec* locals, u32 len)
+{
+    if (len > locals->capacity)
+    {
+        vec_reserve(locals, max(len, locals->capacity * 2));
+    }
+    if (len > locals->length)
+    {
+        memset(locals->data + locals->length, 0, sizeof(TXN_EvalVal)*(len - locals->length));
+    }
+    locals->length = len;
+}
+
+
+
+
+#ifdef TXN_EVAL_THREADED
+# define TXN_EVAL_CASE(name) L_##name:
+# define TXN_EVAL_NEXT() goto *labels[code[pc++]]
+#else
+# define TXN_EVAL_CASE(name) case TXN_EvalOp_##name:
+# define TXN_EVAL_NEXT() goto dispatch
+#endif
+
+#define TXN_EVAL_TOP(i) (stack->data[stack->length - 1 - (i)])
+
+#define TXN_EVAL_NEED(n)                                                \
+    if (stack->length < (n))                                            \
+    {                                                                   \
+        err = TXN_EvalErr_StackUnderflow;                               \
+        goto failed;                                                    \
+    }
+
+#define TXN_EVAL_CALL(f)                                                \
+    {                                                                   \
+        const TXN_EvalFun* callee = prog->funs->data + (f);             \
+        TXN_EvalFrame frame = { pc, base };                             \
+        vec_push(vm->frames, frame);                                    \
+        base = vm->locals->length;                                      \
+        TXN_evalLocalsResize(vm->locals, base + callee->localsTotal);   \
+        pc = callee->entry;                                             \
+    }
+
+#define TXN_EVAL_TAIL_CALL(f)                                           \
+    {                                                                   \
+        const TXN_EvalFun* callee = prog->funs->data + (f);             \
+        vm->locals->length = base;                                      \
+        TXN_evalLocalsResize(vm->locals, base + callee->localsTotal);   \
+        pc = callee->entry;                                             \
+    }
+
+#define TXN_EVAL_BINOP(name)                                            \
+    TXN_EVAL_CASE(name)                                                 \
+    {                                                                   \
+        TXN_EVAL_NEED(2);                                               \
+        err = TXN_evalBinOp(space, TXN_EvalOp_##name, &TXN_EVAL_TOP(1), &TXN_EVAL_TOP(0)); \
+        if (err)                                                        \
+        {                                                               \
+            goto failed;                                                \
+        }                                                               \
+        --stack->length;                                                \
+        TXN_EVAL_NEXT();                                                \
+    }
+
+
+static bool TXN_evalExec(TXN_EvalVM* vm, u32 fun)
+{
+#ifdef TXN_EVAL_THREADED
+    static const void* labels[TXN_NumEvalOps] =
+    {
+# define TXN_EVAL_OP_LABEL(name) &&L_##name,
+        TXN_EVAL_OPS(TXN_EVAL_OP_LABEL)
+# undef TXN_EVAL_OP_LABEL
+    };
+#endif
+    const TXN_EvalProgram* prog = vm->prog;
+    const TXN_Space* space = prog->space;
+    const u32* code = prog->code->data;
+    TXN_EvalValVec* stack = vm->stack;
+    u32 depth = vm->frames->length;
+    u32 localsLen = vm->locals->length;
+    u32 pc = (u32)-1;
+    u32 base = localsLen;
+    TXN_EvalErr err = TXN_EvalErr_None;
+    TXN_EVAL_CALL(fun);
+
+#ifdef TXN_EVAL_THREADED
+    TXN_EVAL_NEXT();
+#else
+dispatch:
+    switch (code[pc++])
+    {
+#endif
+    TXN_EVAL_CASE(Const)
+    {
+        TXN_EvalVal v = prog->consts->data[code[pc++]];
+        vec_push(stack, v);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Quot)
+    {
+        TXN_EvalVal v = { TXN_EvalValType_Quot };
+        v.quot = code[pc++];
+        vec_push(stack, v);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Load)
+    {
+        TXN_EvalVal v = vm->locals->data[base + code[pc++]];
+        vec_push(stack, v);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Store)
+    {
+        TXN_EVAL_NEED(1);
+        vm->locals->data[base + code[pc++]] = vec_pop(stack);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(LoadGlobal)
+    {
+        TXN_EvalVal v = vm->globals->data[code[pc++]];
+        vec_push(stack, v);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(StoreGlobal)
+    {
+        TXN_EVAL_NEED(1);
+        vm->globals->data[code[pc++]] = vec_pop(stack);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Call)
+    {
+        u32 f = code[pc++];
+        TXN_EVAL_CALL(f);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(CallVal)
+    {
+        TXN_EVAL_NEED(1);
+        if (TXN_EvalValType_Quot != TXN_EVAL_TOP(0).type)
+        {
+            TXN_EVAL_NEXT();
+        }
+        u32 f = vec_pop(stack).quot;
+        TXN_EVAL_CALL(f);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Apply)
+    {
+        TXN_EVAL_NEED(1);
+        if (TXN_EvalValType_Quot != TXN_EVAL_TOP(0).type)
+        {
+            err = TXN_EvalErr_Type;
+            goto failed;
+        }
+        u32 f = vec_pop(stack).quot;
+        TXN_EVAL_CALL(f);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(TailCall)
+    {
+        u32 f = code[pc];
+        TXN_EVAL_TAIL_CALL(f);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(TailCallVal)
+    {
+        TXN_EVAL_NEED(1);
+        if (TXN_EvalValType_Quot != TXN_EVAL_TOP(0).type)
+        {
+            TXN_EVAL_NEXT();
+        }
+        u32 f = vec_pop(stack).quot;
+        TXN_EVAL_TAIL_CALL(f);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(TailApply)
+    {
+        TXN_EVAL_NEED(1);
+        if (TXN_EvalValType_Quot != TXN_EVAL_TOP(0).type)
+        {
+            err = TXN_EvalErr_Type;
+            goto failed;
+        }
+        u32 f = vec_pop(stack).quot;
+        TXN_EVAL_TAIL_CALL(f);
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Ret)
+    {
+        TXN_EvalFrame frame = vec_pop(vm->frames);
+        vm->locals->length = base;
+        base = frame.localsBase;
+        pc = frame.retPc;
+        if (vm->frames->length == depth)
+        {
+            return true;
+        }
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Jmp)
+    {
+        pc = code[pc];
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Jz)
+    {
+        TXN_EVAL_NEED(1);
+        TXN_EvalVal c = vec_pop(stack);
+        pc = TXN_evalTruthy(&c) ? (pc + 1) : code[pc];
+        TXN_EVAL_NEXT();
+    }
+
+    TXN_EVAL_BINOP(Add)
+    TXN_EVAL_BINOP(Sub)
+    TXN_EVAL_BINOP(Mul)
+    TXN_EVAL_BINOP(Div)
+    TXN_EVAL_BINOP(Mod)
+    TXN_EVAL_BINOP(Eq)
+    TXN_EVAL_BINOP(Ne)
+    TXN_EVAL_BINOP(Lt)
+    TXN_EVAL_BINOP(Gt)
+    TXN_EVAL_BINOP(Le)
+    TXN_EVAL_BINOP(Ge)
+
+    TXN_EVAL_CASE(Not)
+    {
+        TXN_EVAL_NEED(1);
+        TXN_EvalVal* v = &TXN_EVAL_TOP(0);
+        bool t = TXN_evalTruthy(v);
+        v->type = TXN_EvalValType_Int;
+        v->i = !t;
+        TXN_EVAL_NEXT();
+    }
+
+    TXN_EVAL_CASE(AryNew)
+    {
+        TXN_EVAL_NEED(1);
+        TXN_EvalVal* n = &TXN_EVAL_TOP(0);
+        if ((TXN_EvalValType_Int != n->type) || (n->i < 0) || (n->i > UINT32_MAX))
+        {
+            err = TXN_EvalErr_Type;
+            goto failed;
+        }
+        u32 len = (u32)n->i;
+        TXN_EvalVal ary;
+        s64* elms = TXN_evalAryNew(vm, TXN_EvalAryType_Int, len, &ary)->i;
+        for (u32 i = 0; i < len; ++i)
+        {
+            elms[i] = i;
+        }
+        TXN_EVAL_TOP(0) = ary;
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(AryStore)
+    {
+        TXN_EVAL_NEED(3);
+        TXN_EvalVal* ary = &TXN_EVAL_TOP(2);
+        TXN_EvalVal* idx = &TXN_EVAL_TOP(1);
+        if ((TXN_EvalValType_Ary != ary->type) || (TXN_EvalValType_Int != idx->type))
+        {
+            err = TXN_EvalErr_Type;
+            goto failed;
+        }
+        TXN_EvalAry* a = vm->arys->data[ary->ary];
+        if ((idx->i < 0) || (idx->i >= a->length))
+        {
+            err = TXN_EvalErr_Index;
+            goto failed;
+        }
+        TXN_evalArySet(vm, a, (u32)idx->i, &TXN_EVAL_TOP(0));
+        stack->length -= 3;
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(AryLoad)
+    {
+        TXN_EVAL_NEED(2);
+        TXN_EvalVal* ary = &TXN_EVAL_TOP(1);
+        TXN_EvalVal* idx = &TXN_EVAL_TOP(0);
+        if ((TXN_EvalValType_Ary != ary->type) || (TXN_EvalValType_Int != idx->type))
+        {
+            err = TXN_EvalErr_Type;
+            goto failed;
+        }
+        TXN_EvalAry* a = vm->arys->data[ary->ary];
+        if ((idx->i < 0) || (idx->i >= a->length))
+        {
+            err = TXN_EvalErr_Index;
+            goto failed;
+        }
+        *ary = TXN_evalAryGet(a, (u32)idx->i);
+        --stack->length;
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(ArySize)
+    {
+        TXN_EVAL_NEED(1);
+        TXN_EvalVal* ary = &TXN_EVAL_TOP(0);
+        if (TXN_EvalValType_Ary != ary->type)
+        {
+            err = TXN_EvalErr_Type;
+            goto failed;
+        }
+        s64 len = vm->arys->data[ary->ary]->length;
+        ary->type = TXN_EvalValType_Int;
+        ary->i = len;
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Map)
+    TXN_EVAL_CASE(Filter)
+    TXN_EVAL_CASE(Reduce)
+    {
+        TXN_EVAL_NEED(2);
+        TXN_EvalVal ary = TXN_EVAL_TOP(1);
+        TXN_EvalVal quot = TXN_EVAL_TOP(0);
+        if ((TXN_EvalValType_Ary != ary.type) || (TXN_EvalValType_Quot != quot.type))
+        {
+            err = TXN_EvalErr_Type;
+            goto failed;
+        }
+        stack->length -= 2;
+        err = TXN_evalAryApply(vm, (TXN_EvalOp)code[pc - 1], ary, quot.quot);
+        if (err)
+        {
+            goto failed;
+        }
+        TXN_EVAL_NEXT();
+    }
+    TXN_EVAL_CASE(Gc)
+    {
+        if (!vm->applyDepth)
+        {
+            TXN_evalGc(vm);
+        }
+        TXN_EVAL_NEXT();
+    }
+#ifndef TXN_EVAL_THREADED
+    default:
+        assert(false);
+        break;
+    }
+#endif
+
+failed:
+    if (!vm->err.err)
+    {
+        vm->err.err = err;
+        vm->err.node.id = prog->codeNodes->data[pc - 1];
+    }
+    vm->frames->length = depth;
+    vm->locals->length = localsLen;
+    return false;
+}
+
+
+
+
+bool TXN_evalRun(TXN_EvalVM* vm)
+{
+    vm->err.err = TXN_EvalErr_None;
+    vm->err.node = TXN_Node_Invalid;
+    return TXN_evalExec(vm, 0);
+}
@@ -0,0 +1,222 @@
+#include "txn_a.h"
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# define NOMINMAX
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+
+
+
+static TXN_Node TXN_parseFileRead(TXN_Space* space, const char* path, TXN_SpaceSrcInfo* srcInfo)
+{
+    char* text;
+    u32 textSize = FILEU_readFile(path, &text);
+    if (-1 == textSize)
+    {
+        return TXN_Node_Invalid;
+    }
+    TXN_Node root = TXN_parseBufAsList(space, text, textSize, srcInfo);
+    free(text);
+    return root;
+}
+
+
+
+#ifdef _WIN32
+
+TXN_Node TXN_parseFile(TXN_Space* space, const char* path, TXN_SpaceSrcInfo* srcInfo)
+{
+    HANDLE file = CreateFileA
+    (
+        path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL
+    );
+    if (INVALID_HANDLE_VALUE == file)
+    {
+        return TXN_Node_Invalid;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || (0 == size.QuadPart) || (size.QuadPart >= UINT32_MAX))
+    {
+        CloseHandle(file);
+        return TXN_parseFileRead(space, path, srcInfo);
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const char* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!view)
+    {
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return TXN_parseFileRead(space, path, srcInfo);
+    }
+    TXN_Node root = TXN_parseBufAsList(space, view, (u32)size.QuadPart, srcInfo);
+    UnmapViewOfFile(view);
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return root;
+}
+
+#else
+
+TXN_Node TXN_parseFile(TXN_Space* space, const char* path, TXN_SpaceSrcInfo* srcInfo)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return TXN_Node_Invalid;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (0 == st.st_size) || ((u64)st.st_size >= UINT32_MAX))
+    {
+        close(fd);
+        return TXN_parseFileRead(space, path, srcInfo);
+    }
+    size_t size = (size_t)st.st_size;
+    void* view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == view)
+    {
+        return TXN_parseFileRead(space, path, srcInfo);
+    }
+    madvise(view, size, MADV_SEQUENTIAL);
+    TXN_Node root = TXN_parseBufAsList(space, view, (u32)size, srcInfo);
+    munmap(view, size);
+    return root;
+}
+
+#endif
+
+
+
+
+typedef struct TXN_LoadFile
+{
+    u32 worker;
+    u32 begin;
+    u32 end;
+    u32 srcInfoBegin;
+    u32 srcInfoEnd;
+    TXN_Node root;
+} TXN_LoadFile;
+
+
+typedef struct TXN_LoadStage
+{
+    TXN_Space* space;
+    TXN_SpaceSrcInfo srcInfo[1];
+} TXN_LoadStage;
+
+
+typedef struct TXN_LoadCtx
+{
+    const char* const* paths;
+    TXN_LoadFile* files;
+    u32 filesTotal;
+    TXN_LoadStage* stages;
+    bool withSrcInfo;
+    bool prescan;
+    const TXN_SharedPool* shared;
+    volatile u32 next;
+} TXN_LoadCtx;
+
+
+
+static void TXN_loadWorker(void* arg, u32 worker)
+{
+    TXN_LoadCtx* ctx = arg;
+    TXN_LoadStage* stage = ctx->stages + worker;
+    stage->space = ctx->shared ? TXN_spaceNewShared(ctx->shared) : TXN_spaceNew();
+    TXN_spaceSetPrescan(stage->space, ctx->prescan);
+    for (;;)
+    {
+        u32 i = TXN_atomicInc(&ctx->next);
+        if (i >= ctx->filesTotal)
+        {
+            break;
+        }
+        TXN_LoadFile* file = ctx->files + i;
+        file->worker = worker;
+        file->begin = TXN_spaceNodesTotal(stage->space);
+        file->srcInfoBegin = stage->srcInfo->nodes->length;
+        file->root = TXN_Node_Invalid;
+
+        file->root = TXN_parseFile(stage->space, ctx->paths[i], ctx->withSrcInfo ? stage->srcInfo : NULL);
+        file->end = TXN_spaceNodesTotal(stage->space);
+        file->srcInfoEnd = stage->srcInfo->nodes->length;
+    }
+}
+
+
+
+u32 TXN_loadFiles
+(
+    TXN_Space* space, const char* const* paths, u32 count, TXN_Node* roots, TXN_SpaceSrcInfo* srcInfo,
+    const TXN_ParallelOpt* opt
+)
+{
+    u32 threads = (opt && opt->threads) ? opt->threads : TXN_cpuCount();
+    threads = max(1, min(threads, count));
+
+    TXN_LoadFile* files = zalloc(sizeof(*files) * max(1, count));
+    TXN_LoadStage* stages = zalloc(sizeof(*stages) * threads);
+    TXN_LoadCtx ctx[1] = { { paths, files, count, stages, srcInfo != NULL, space->prescan, space->shared, 0 } };
+    if (threads > 1)
+    {
+        TXN_runWorkers(threads, TXN_loadWorker, ctx);
+    }
+    else
+    {
+        TXN_loadWorker(ctx, 0);
+    }
+
+    u32 loaded = 0;
+    for (u32 i = 0; i < count; ++i)
+    {
+        const TXN_LoadFile* file = files + i;
+        const TXN_LoadStage* stage = stages + file->worker;
+        u32 base = TXN_spaceNodesTotal(space);
+        if (srcInfo)
+        {
+            vec_push(srcInfo->fileBases, base);
+        }
+        roots[i] = TXN_Node_Invalid;
+        if (TXN_Node_Invalid.id == file->root.id)
+        {
+            continue;
+        }
+        TXN_spaceImport(space, stage->space, file->begin, file->end);
+        roots[i].id = file->root.id - file->begin + base;
+        ++loaded;
+        if (srcInfo)
+        {
+            assert(file->srcInfoEnd - file->srcInfoBegin == file->end - file->begin);
+            for (u32 j = 0; j < file->end - file->begin; ++j)
+            {
+                TXN_NodeSrcInfo info = stage->srcInfo->nodes->data[file->srcInfoBegin + j];
+                info.file = srcInfo->fileBases->length - 1;
+                vec_push(srcInfo->nodes, info);
+            }
+        }
+    }
+
+    for (u32 i = 0; i < threads; ++i)
+    {
+        if (stages[i].space)
+        {
+            TXN_spaceSrcInfoFree(stages[i].srcInfo);
+            TXN_spaceFree(stages[i].space);
+        }
+    }
+    free(stages);
+    free(files);
+    return loaded;
+}
@@ -48,10 +48,8 @@ typedef struct TXN_ParseContext
     u32 cur;
     u32 curLine;
     TXN_SpaceSrcInfo* srcInfo;
-    vec_char tmpStrBuf[1];
     TXN_ParseSeqStack seqStack[1];
-    TXN_NodeVec seqDefStack[1];
-    TXN_SeqDefFrameVec seqDefFrameStack[1];
+    TXN_Builder builder[1];
 } TXN_ParseContext;
 
 
@@ -61,28 +59,26 @@ static TXN_ParseContext TXN_parseContextNew
     TXN_Space* space, u32 strSize, const char* srcStr, TXN_SpaceSrcInfo* srcInfo
 )
 {
-    assert(strSize == strlen(srcStr));
     if (srcInfo)
     {
         vec_push(srcInfo->fileBases, TXN_spaceNodesTotal(space));
     }
     TXN_ParseContext ctx = { space, strSize, srcStr, 0, 1, srcInfo };
+    ctx.builder->space = space;
     return ctx;
 }
 
 static void TXN_parseContextFree(TXN_ParseContext* ctx)
 {
-    vec_free(ctx->seqDefFrameStack);
-    vec_free(ctx->seqDefStack);
+    TXN_builderDeinit(ctx->builder);
     vec_free(ctx->seqStack);
-    vec_free(ctx->tmpStrBuf);
 }
 
 
 
 
 
-static bool TXN_skipSapce(TXN_ParseContext* ctx)
+static bool TXN_skipSapceImpl(TXN_ParseContext* ctx)
 {
     const char* src = ctx->src;
     for (;;)
@@ -104,11 +100,13 @@ static bool TXN_skipSapce(TXN_ParseContext* ctx)
         {
             if (0 == strncmp("//", src + ctx->cur, 2))
             {
+                TXN_STAT(u32 comment0 = ctx->cur);
                 ctx->cur += 2;
                 for (;;)
                 {
                     if (ctx->cur >= ctx->srcLen)
                     {
+                        TXN_STAT(ctx->space->stats->commentBytes += ctx->cur - comment0);
                         return false;
                     }
                     else if ('\n' == src[ctx->cur])
@@ -119,16 +117,19 @@ static bool TXN_skipSapce(TXN_ParseContext* ctx)
                     }
                     ++ctx->cur;
                 }
+                TXN_STAT(ctx->space->stats->commentBytes += ctx->cur - comment0);
                 continue;
             }
             else if (0 == strncmp("/*", src + ctx->cur, 2))
             {
+                TXN_STAT(u32 comment0 = ctx->cur);
                 ctx->cur += 2;
                 u32 n = 1;
                 for (;;)
                 {
                     if (ctx->cur >= ctx->srcLen)
                     {
+                        TXN_STAT(ctx->space->stats->commentBytes += ctx->cur - comment0);
                         return false;
                     }
                     else if (ctx->cur + 1 < ctx->srcLen)
@@ -157,6 +158,7 @@ static bool TXN_skipSapce(TXN_ParseContext* ctx)
                     }
                     ++ctx->cur;
                 }
+                TXN_STAT(ctx->space->stats->commentBytes += ctx->cur - comment0);
                 continue;
             }
         }
@@ -166,6 +168,23 @@ static bool TXN_skipSapce(TXN_ParseContext* ctx)
 }
 
 
+static bool TXN_skipSapce(TXN_ParseContext* ctx)
+{
+#ifdef TXN_STATS
+    TXN_Stats* stats = ctx->space->stats;
+    u64 t0 = TXN_statsNow();
+    u32 cur0 = ctx->cur;
+    u64 commentBytes0 = stats->commentBytes;
+    bool r = TXN_skipSapceImpl(ctx);
+    stats->spaceBytes += (ctx->cur - cur0) - (stats->commentBytes - commentBytes0);
+    stats->cycles[TXN_StatsPhase_Skip] += TXN_statsNow() - t0;
+    return r;
+#else
+    return TXN_skipSapceImpl(ctx);
+#endif
+}
+
+
 
 
 
@@ -335,6 +354,7 @@ static void TXN_tokenToNodeSrcInfo(TXN_ParseContext* ctx, const TXN_Token* tok,
     {
         return;
     }
+    TXN_STAT(u64 t0 = TXN_statsNow());
     assert(ctx->srcInfo->fileBases->length > 0);
     info->file = ctx->srcInfo->fileBases->length - 1;
     info->offset = tok->begin;
@@ -350,6 +370,7 @@ static void TXN_tokenToNodeSrcInfo(TXN_ParseContext* ctx, const TXN_Token* tok,
         }
     }
     info->isQuotStr = TXN_TokenType_String == tok->type;
+    TXN_STAT(ctx->space->stats->cycles[TXN_StatsPhase_SrcInfo] += TXN_statsNow() - t0);
 }
 
 
@@ -357,6 +378,34 @@ static void TXN_tokenToNodeSrcInfo(TXN_ParseContext* ctx, const TXN_Token* tok,
 
 
 
+static u32 TXN_unescapeToTmpBuf(TXN_Space* space, const char* src, const char* esc, u32 srcLen)
+{
+    TXN_STAT(u64 t0 = TXN_statsNow());
+    vec_resize(space->tmpBuf, srcLen + 1);
+    char* dst = space->tmpBuf->data;
+    const char* end = src + srcLen;
+    u32 n = 0;
+    while (esc)
+    {
+        assert(esc + 1 < end);
+        u32 a = (u32)(esc - src);
+        memcpy(dst + n, src, a);
+        n += a;
+        dst[n++] = esc[1];
+        src = esc + 2;
+        esc = memchr(src, '\\', end - src);
+    }
+    u32 a = (u32)(end - src);
+    memcpy(dst + n, src, a);
+    n += a;
+    dst[n] = 0;
+    TXN_STAT(space->stats->cycles[TXN_StatsPhase_Unescape] += TXN_statsNow() - t0);
+    return n;
+}
+
+
+
+
 static bool TXN_tokenToNode(TXN_ParseContext* ctx, const TXN_Token* tok, TXN_Node* pNode)
 {
     TXN_Space* space = ctx->space;
@@ -365,39 +414,26 @@ static bool TXN_tokenToNode(TXN_ParseContext* ctx, const TXN_Token* tok, TXN_Nod
     {
     case TXN_TokenType_Text:
     {
+        TXN_STAT(++space->stats->textToks);
         const char* str = ctx->src + tok->begin;
-        *pNode = TXN_tokFromBuf(space, str, tok->len, isQuotStr);
+        vec_resize(space->tmpBuf, tok->len + 1);
+        memcpy(space->tmpBuf->data, str, tok->len);
+        space->tmpBuf->data[tok->len] = 0;
+        *pNode = TXN_tokFromTmpBuf(space, tok->len, 0);
         break;
     }
     case TXN_TokenType_String:
     {
-        char endCh = ctx->src[tok->begin - 1];
-        const char* src = ctx->src + tok->begin;
-        u32 n = 0;
-        for (u32 i = 0; i < tok->len; ++i)
-        {
-            if ('\\' == src[i])
-            {
-                ++n;
-                ++i;
-            }
-        }
-        u32 len = tok->len - n;
-        vec_resize(ctx->tmpStrBuf, len + 1);
-        u32 si = 0;
-        for (u32 i = 0; i < tok->len; ++i)
+        TXN_STAT(++space->stats->stringToks);
+        const char* str = ctx->src + tok->begin;
+        const char* esc = memchr(str, '\\', tok->len);
+        if (!esc)
         {
-            if ('\\' == src[i])
-            {
-                ++i;
-                ctx->tmpStrBuf->data[si++] = src[i];
-                continue;
-            }
-            ctx->tmpStrBuf->data[si++] = src[i];
+            *pNode = TXN_tokFromBuf(space, str, tok->len, isQuotStr);
+            break;
         }
-        ctx->tmpStrBuf->data[len] = 0;
-        assert(si == len);
-        *pNode = TXN_tokFromBuf(space, ctx->tmpStrBuf->data, len, isQuotStr);
+        u32 len = TXN_unescapeToTmpBuf(space, str, esc, tok->len);
+        *pNode = TXN_tokFromTmpBuf(space, len, TXN_tokFlags(space->tmpBuf->data, len, isQuotStr));
         break;
     }
     case TXN_TokenType_SeqParenBegin:
@@ -419,45 +455,6 @@ static bool TXN_tokenToNode(TXN_ParseContext* ctx, const TXN_Token* tok, TXN_Nod
 
 
 
-static void TXN_addSeqEnter(TXN_ParseContext* ctx, TXN_NodeType type)
-{
-    assert(type > TXN_NodeType_Tok);
-    TXN_SeqDefFrame f = { type, ctx->seqDefStack->length };
-    vec_push(ctx->seqDefFrameStack, f);
-}
-
-static void TXN_addSeqPush(TXN_ParseContext* ctx, TXN_Node x)
-{
-    vec_push(ctx->seqDefStack, x);
-}
-
-static void TXN_addSeqCancel(TXN_ParseContext* ctx)
-{
-    assert(ctx->seqDefFrameStack->length > 0);
-    TXN_SeqDefFrame f = vec_last(ctx->seqDefFrameStack);
-    vec_pop(ctx->seqDefFrameStack);
-    vec_resize(ctx->seqDefStack, f.p);
-}
-
-static TXN_Node TXN_addSeqDone(TXN_ParseContext* ctx)
-{
-    TXN_Space* space = ctx->space;
-    assert(ctx->seqDefFrameStack->length > 0);
-    TXN_SeqDefFrame f = vec_last(ctx->seqDefFrameStack);
-    vec_pop(ctx->seqDefFrameStack);
-    u32 len = ctx->seqDefStack->length - f.p;
-    TXN_Node* elms = ctx->seqDefStack->data + f.p;
-    TXN_Node node = TXN_seqNew(space, f.seqType, elms, len);
-    vec_resize(ctx->seqDefStack, f.p);
-    return node;
-}
-
-
-
-
-
-
-
 static bool TXN_parseEnd(TXN_ParseContext* ctx)
 {
     assert(ctx->srcLen >= ctx->cur);
@@ -472,6 +469,7 @@ static bool TXN_parseSeqEnd(TXN_ParseContext* ctx, TXN_TokenType endTokType)
 {
     u32 cur0 = ctx->cur;
     u32 curLine0 = ctx->curLine;
+    TXN_STAT(TXN_Stats stats0 = *ctx->space->stats);
     TXN_Token tok[1];
     if (!TXN_readToken(ctx, tok))
     {
@@ -483,6 +481,8 @@ static bool TXN_parseSeqEnd(TXN_ParseContext* ctx, TXN_TokenType endTokType)
     }
     ctx->cur = cur0;
     ctx->curLine = curLine0;
+    TXN_STAT(ctx->space->stats->spaceBytes = stats0.spaceBytes);
+    TXN_STAT(ctx->space->stats->commentBytes = stats0.commentBytes);
     return false;
 }
 
@@ -491,6 +491,76 @@ static bool TXN_parseSeqEnd(TXN_ParseContext* ctx, TXN_TokenType endTokType)
 
 
 
+bool TXN_parseCount(const char* src, u32 srcLen, TXN_ParseCounts* out)
+{
+    // the lexer only touches its space for stats
+    TXN_Space scratch[1] = { 0 };
+    TXN_ParseContext ctx[1] = { { scratch, srcLen, src, 0, 1 } };
+    memset(out, 0, sizeof(*out));
+    // elements collected so far by each open seq, the outermost being the list itself
+    vec_u32 open[1] = { 0 };
+    vec_push(open, 0);
+    u32 openElms = 0;
+    bool ok = true;
+    TXN_Token tok[1];
+    while (ok && TXN_readToken(ctx, tok))
+    {
+        switch (tok->type)
+        {
+        case TXN_TokenType_Text:
+        case TXN_TokenType_String:
+            ++out->toks;
+            out->payloadBytes += tok->len + 1;
+            out->maxTokLen = max(out->maxTokLen, tok->len);
+            ++vec_last(open);
+            ++openElms;
+            break;
+        case TXN_TokenType_SeqParenBegin:
+        case TXN_TokenType_SeqSquareBegin:
+        case TXN_TokenType_SeqBraceBegin:
+            ++out->seqs;
+            vec_push(open, 0);
+            out->maxDepth = max(out->maxDepth, open->length - 1);
+            break;
+        default:
+            if (open->length < 2)
+            {
+                ok = false;
+                break;
+            }
+            openElms -= vec_pop(open);
+            ++vec_last(open);
+            ++openElms;
+            break;
+        }
+        out->maxOpenElms = max(out->maxOpenElms, openElms);
+    }
+    ok = ok && (1 == open->length);
+    out->payloadBytes += (u64)sizeof(TXN_Node) * (out->toks + out->seqs);
+    vec_free(open);
+    return ok;
+}
+
+
+static void TXN_parsePresize(TXN_ParseContext* ctx)
+{
+    if (!ctx->space->prescan)
+    {
+        return;
+    }
+    TXN_ParseCounts counts[1];
+    TXN_parseCount(ctx->src, ctx->srcLen, counts);
+    TXN_spaceReserve(ctx->space, ctx->srcInfo, counts);
+    vec_reserve(ctx->seqStack, counts->maxDepth);
+    vec_reserve(ctx->builder->seqDefStack, counts->maxOpenElms);
+    vec_reserve(ctx->builder->seqDefFrameStack, counts->maxDepth + 1);
+}
+
+
+
+
+
+
 static TXN_Node TXN_parseSeq(TXN_ParseContext* ctx, const TXN_Token* beginTok)
 {
     TXN_Space* space = ctx->space;
@@ -499,7 +569,7 @@ static TXN_Node TXN_parseSeq(TXN_ParseContext* ctx, const TXN_Token* beginTok)
     assert(!seqStack->length);
 
     TXN_ParseSeqLevel root = { beginTok->type, -1 };
-    vec_push(seqStack, root);
+    TXN_vecPush(space, seqStack, root);
     TXN_ParseSeqLevel* cur = NULL;
     TXN_Node r;
     TXN_Token tok[1];
@@ -511,6 +581,8 @@ next:
     cur = &vec_last(seqStack);
     if (-1 == cur->endTokType)
     {
+        TXN_STAT(++space->stats->seqToks);
+        TXN_STAT(space->stats->maxDepth = max(space->stats->maxDepth, seqStack->length));
         TXN_NodeType seqType;
         switch (cur->beginTokType)
         {
@@ -530,22 +602,22 @@ next:
             assert(false);
             break;
         }
-        TXN_addSeqEnter(ctx, seqType);
+        TXN_builderSeqBegin(ctx->builder, seqType);
     }
     else
     {
-        TXN_addSeqPush(ctx, r);
+        TXN_builderPush(ctx->builder, r);
     }
     if (TXN_parseSeqEnd(ctx, cur->endTokType))
     {
         vec_pop(seqStack);
-        r = TXN_addSeqDone(ctx);
+        r = TXN_builderSeqEnd(ctx->builder);
         assert(r.id != TXN_Node_Invalid.id);
         if (srcInfo)
         {
             TXN_NodeSrcInfo nodeSrcInfo = { 0 };
             TXN_tokenToNodeSrcInfo(ctx, beginTok, &nodeSrcInfo);
-            vec_push(srcInfo->nodes, nodeSrcInfo);
+            TXN_vecPush(space, srcInfo->nodes, nodeSrcInfo);
         }
         goto next;
     }
@@ -558,7 +630,7 @@ next:
         if (!TXN_tokenToNode(ctx, tok, &r))
         {
             TXN_ParseSeqLevel l = { tok->type, -1 };
-            vec_push(seqStack, l);
+            TXN_vecPush(space, seqStack, l);
             goto next;
         }
         assert(r.id != TXN_Node_Invalid.id);
@@ -566,13 +638,13 @@ next:
         {
             TXN_NodeSrcInfo nodeSrcInfo = { 0 };
             TXN_tokenToNodeSrcInfo(ctx, tok, &nodeSrcInfo);
-            vec_push(srcInfo->nodes, nodeSrcInfo);
+            TXN_vecPush(space, srcInfo->nodes, nodeSrcInfo);
         }
         goto next;
     }
 failed:
     vec_resize(seqStack, 0);
-    TXN_addSeqCancel(ctx);
+    TXN_builderSeqCancel(ctx->builder);
     return TXN_Node_Invalid;
 }
 
@@ -601,7 +673,7 @@ static TXN_Node TXN_parseNode(TXN_ParseContext* ctx)
     {
         TXN_NodeSrcInfo nodeSrcInfo = { 0 };
         TXN_tokenToNodeSrcInfo(ctx, tok, &nodeSrcInfo);
-        vec_push(srcInfo->nodes, nodeSrcInfo);
+        TXN_vecPush(space, srcInfo->nodes, nodeSrcInfo);
     }
     return node;
 }
@@ -618,9 +690,10 @@ static TXN_Node TXN_parseNode(TXN_ParseContext* ctx)
 
 
 
-TXN_Node TXN_parseAsCell(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* srcInfo)
+static TXN_Node TXN_parseAsCellImpl(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* srcInfo)
 {
     TXN_ParseContext ctx[1] = { TXN_parseContextNew(space, (u32)strlen(src), src, srcInfo) };
+    TXN_parsePresize(ctx);
     TXN_Node node = TXN_parseNode(ctx);
     if ((TXN_Node_Invalid.id == node.id) || (!TXN_parseEnd(ctx)))
     {
@@ -631,10 +704,11 @@ TXN_Node TXN_parseAsCell(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* sr
     return node;
 }
 
-TXN_Node TXN_parseAsList(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* srcInfo)
+static TXN_Node TXN_parseAsListImpl(TXN_Space* space, const char* src, u32 srcLen, TXN_SpaceSrcInfo* srcInfo)
 {
-    TXN_ParseContext ctx[1] = { TXN_parseContextNew(space, (u32)strlen(src), src, srcInfo) };
-    TXN_addSeqEnter(ctx, TXN_NodeType_SeqNaked);
+    TXN_ParseContext ctx[1] = { TXN_parseContextNew(space, srcLen, src, srcInfo) };
+    TXN_parsePresize(ctx);
+    TXN_builderSeqBegin(ctx->builder, TXN_NodeType_SeqNaked);
     bool errorHappen = false;
     while (TXN_skipSapce(ctx))
     {
@@ -644,19 +718,19 @@ TXN_Node TXN_parseAsList(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* sr
             errorHappen = true;
             break;
         }
-        TXN_addSeqPush(ctx, e);
+        TXN_builderPush(ctx->builder, e);
     }
     if (!TXN_parseEnd(ctx) || errorHappen)
     {
-        TXN_addSeqCancel(ctx);
+        TXN_builderSeqCancel(ctx->builder);
         TXN_parseContextFree(ctx);
         return TXN_Node_Invalid;
     }
-    TXN_Node node = TXN_addSeqDone(ctx);
+    TXN_Node node = TXN_builderSeqEnd(ctx->builder);
     if (srcInfo)
     {
         TXN_NodeSrcInfo nodeSrcInfo = { srcInfo->fileBases->length - 1 };
-        vec_push(srcInfo->nodes, nodeSrcInfo);
+        TXN_vecPush(space, srcInfo->nodes, nodeSrcInfo);
     }
     TXN_parseContextFree(ctx);
     return node;
@@ -665,6 +739,30 @@ TXN_Node TXN_parseAsList(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* sr
 
 
 
+TXN_Node TXN_parseAsCell(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* srcInfo)
+{
+    TXN_STAT(u64 t0 = TXN_statsNow());
+    TXN_Node node = TXN_parseAsCellImpl(space, src, srcInfo);
+    TXN_STAT(space->stats->cycles[TXN_StatsPhase_Parse] += TXN_statsNow() - t0);
+    return node;
+}
+
+TXN_Node TXN_parseAsList(TXN_Space* space, const char* src, TXN_SpaceSrcInfo* srcInfo)
+{
+    return TXN_parseBufAsList(space, src, (u32)strlen(src), srcInfo);
+}
+
+TXN_Node TXN_parseBufAsList(TXN_Space* space, const char* src, u32 srcLen, TXN_SpaceSrcInfo* srcInfo)
+{
+    TXN_STAT(u64 t0 = TXN_statsNow());
+    TXN_Node node = TXN_parseAsListImpl(space, src, srcLen, srcInfo);
+    TXN_STAT(space->stats->cycles[TXN_StatsPhase_Parse] += TXN_statsNow() - t0);
+    return node;
+}
+
+
+
+
 
 
 
@@ -36,14 +36,109 @@ static void TXN_seqBracketChs(TXN_NodeType type, char ch[2])
 
 
 
+typedef struct TXN_PrintSlOut
+{
+    char* ptr;
+    u32 remain;
+    u32 n;
+} TXN_PrintSlOut;
+
+static void TXN_printSlOut(TXN_PrintSlOut* out, const char* s, u32 a)
+{
+    u32 wn = min(a, out->remain);
+    if (wn > 0)
+    {
+        memcpy(out->ptr, s, wn);
+        out->ptr += wn;
+        out->remain -= wn;
+    }
+    out->n += a;
+}
+
+
+
+static bool TXN_printSlNeedEsc(char c)
+{
+    switch (c)
+    {
+    case '(':
+    case ')':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+    case '"':
+    case '\'':
+        return true;
+    default:
+        return ' ' >= c;
+    }
+}
+
+
+#ifdef TXN_USE_SSE2
+static u32 TXN_printSlEscMask16(const char* s)
+{
+    __m128i x = _mm_loadu_si128((const __m128i*)s);
+#if CHAR_MIN < 0
+    __m128i m = _mm_cmplt_epi8(x, _mm_set1_epi8(' ' + 1));
+#else
+    __m128i m = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(' ')), x);
+#endif
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('(')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8(')')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('[')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8(']')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('{')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('}')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('"')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('\'')));
+    return _mm_movemask_epi8(m);
+}
+#endif
+
+
+static void TXN_printSlEscape(TXN_PrintSlOut* out, const char* str, u32 len)
+{
+    u32 run = 0;
+    u32 i = 0;
+    while (i < len)
+    {
+#ifdef TXN_USE_SSE2
+        if (i + 16 <= len)
+        {
+            u32 mask = TXN_printSlEscMask16(str + i);
+            if (!mask)
+            {
+                i += 16;
+                continue;
+            }
+            i += ctz32(mask);
+        }
+        else
+#endif
+        if (!TXN_printSlNeedEsc(str[i]))
+        {
+            ++i;
+            continue;
+        }
+        TXN_printSlOut(out, str + run, i - run);
+        TXN_printSlOut(out, "\\", 1);
+        run = i++;
+    }
+    TXN_printSlOut(out, str + run, len - run);
+}
+
+
+
+
 static u32 TXN_printSlTok(const TXN_Space* space, char* buf, u32 bufSize, const TXN_SpaceSrcInfo* srcInfo, TXN_Node src)
 {
     assert(TXN_nodeIsTok(space, src));
 
     TXN_NodeInfo* info = space->nodes->data + src.id;
-    const char* str = upool_elmData(space->dataPool, info->offset);
+    const char* str = TXN_tokDataAt(space, info->offset);
     u32 sreLen = info->length;
-    u32 n;
     bool isQuotStr = false;
     if (srcInfo && (src.id < srcInfo->nodes->length))
     {
@@ -51,59 +146,24 @@ static u32 TXN_printSlTok(const TXN_Space* space, char* buf, u32 bufSize, const
     }
     else
     {
-        for (u32 i = 0; i < sreLen; ++i)
-        {
-            if (strchr("()[]{}\"' \t\n\r\b\f", str[i]))
-            {
-                isQuotStr = true;
-                break;
-            }
-        }
+        isQuotStr = (info->flags & TXN_NodeFlag_NeedQuote) != 0;
     }
+    TXN_PrintSlOut out[1] = { { buf, (buf && bufSize) ? (bufSize - 1) : 0 } };
     if (isQuotStr)
     {
-        u32 l = 2;
-        for (u32 i = 0; i < sreLen; ++i)
-        {
-            if (' ' >= str[i])
-            {
-                ++l;
-            }
-            else if (strchr("()[]{}\"'", str[i]))
-            {
-                ++l;
-            }
-            ++l;
-        }
-        if (buf && (l < bufSize))
-        {
-            n = 0;
-            buf[n++] = '"';
-            for (u32 i = 0; i < sreLen; ++i)
-            {
-                if (' ' >= str[i])
-                {
-                    buf[n++] = '\\';
-                }
-                else if (strchr("()[]{}\"'", str[i]))
-                {
-                    buf[n++] = '\\';
-                }
-                buf[n++] = str[i];
-            }
-            buf[n++] = '"';
-            assert(n == l);
-        }
-        else
-        {
-            n = l;
-        }
+        TXN_printSlOut(out, "\"", 1);
+        TXN_printSlEscape(out, str, sreLen);
+        TXN_printSlOut(out, "\"", 1);
     }
     else
     {
-        n = snprintf(buf, bufSize, "%s", str);
+        TXN_printSlOut(out, str, sreLen);
     }
-    return n;
+    if (buf && bufSize)
+    {
+        *out->ptr = 0;
+    }
+    return out->n;
 }
 
 
@@ -123,7 +183,10 @@ typedef vec_t(TXN_PrintSlSeqLevel) TXN_PrintSlSeqStack;
 
 
 
-static u32 TXN_printSlSeq(const TXN_Space* space, char* buf, u32 bufSize, const TXN_SpaceSrcInfo* srcInfo, TXN_Node src)
+static u32 TXN_printSlSeq
+(
+    const TXN_Space* space, char* buf, u32 bufSize, const TXN_SpaceSrcInfo* srcInfo, TXN_Node src, u32 limit
+)
 {
     TXN_PrintSlSeqStack seqStack[1] = { 0 };
 
@@ -134,13 +197,17 @@ static u32 TXN_printSlSeq(const TXN_Space* space, char* buf, u32 bufSize, const
     u32 bufRemain = bufSize;
     char* bufPtr = buf;
     u32 n = 0;
+    if (buf && bufSize)
+    {
+        *buf = 0;
+    }
 
     TXN_PrintSlSeqLevel* top = NULL;
     TXN_Node node;
     TXN_NodeInfo* seqInfo = NULL;
     u32 p;
 next:
-    if (!seqStack->length)
+    if (!seqStack->length || (n > limit))
     {
         vec_free(seqStack);
         return n;
@@ -170,13 +237,30 @@ next:
             n += 1;
         }
     }
-    else
+    else if (p < seqInfo->length)
     {
-        if (p < seqInfo->length)
+        if (1 < bufRemain)
+        {
+            *bufPtr = ' ';
+            bufRemain -= 1;
+            bufPtr += 1;
+        }
+        else
         {
+            bufRemain = 0;
+            bufPtr = NULL;
+        }
+        n += 1;
+    }
+    if (p == seqInfo->length)
+    {
+        if (top->ch[0])
+        {
+            assert(top->ch[1]);
             if (1 < bufRemain)
             {
-                *bufPtr = ' ';
+                *bufPtr = top->ch[1];
+                *(bufPtr + 1) = 0;
                 bufRemain -= 1;
                 bufPtr += 1;
             }
@@ -187,29 +271,8 @@ next:
             }
             n += 1;
         }
-        else
-        {
-            assert(p == seqInfo->length);
-            if (top->ch[0])
-            {
-                assert(top->ch[1]);
-                if (1 < bufRemain)
-                {
-                    *bufPtr = top->ch[1];
-                    *(bufPtr + 1) = 0;
-                    bufRemain -= 1;
-                    bufPtr += 1;
-                }
-                else
-                {
-                    bufRemain = 0;
-                    bufPtr = NULL;
-                }
-                n += 1;
-            }
-            vec_pop(seqStack);
-            goto next;
-        }
+        vec_pop(seqStack);
+        goto next;
     }
     TXN_Node e = ((TXN_Node*)upool_elmData(space->dataPool, seqInfo->offset))[p];
     if (TXN_nodeIsTok(space, e))
@@ -242,7 +305,11 @@ next:
 
 
 
-u32 TXN_printSL(const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_SpaceSrcInfo* srcInfo)
+// stops early once the output is known to exceed limit, the result is then only a lower bound
+static u32 TXN_printSlNode
+(
+    const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_SpaceSrcInfo* srcInfo, u32 limit
+)
 {
     if (TXN_nodeIsTok(space, node))
     {
@@ -250,11 +317,20 @@ u32 TXN_printSL(const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, c
     }
     else
     {
-        return TXN_printSlSeq(space, buf, bufSize, srcInfo, node);
+        return TXN_printSlSeq(space, buf, bufSize, srcInfo, node, limit);
     }
 }
 
 
+u32 TXN_printSL(const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_SpaceSrcInfo* srcInfo)
+{
+    TXN_STAT(u64 t0 = TXN_statsNow());
+    u32 n = TXN_printSlNode(space, node, buf, bufSize, srcInfo, (u32)-1);
+    TXN_STAT(TXN_spaceStatsOf(space)->cycles[TXN_StatsPhase_PrintSL] += TXN_statsNow() - t0);
+    return n;
+}
+
+
 
 
 
@@ -424,7 +500,8 @@ next:
     {
         u32 bufRemain = (ctx->bufSize > ctx->n) ? (ctx->bufSize - ctx->n) : 0;
         char* bufPtr = ctx->buf ? (ctx->buf + ctx->n) : NULL;
-        u32 a = TXN_printSL(space, top->src, bufPtr, bufRemain, ctx->opt->srcInfo);
+        u32 limit = (ctx->opt->width > ctx->column) ? (ctx->opt->width - ctx->column) : 0;
+        u32 a = TXN_printSlNode(space, top->src, bufPtr, bufRemain, ctx->opt->srcInfo, limit);
         bool ok = TXN_printMlForward(ctx, a);
         if (ok)
         {
@@ -491,7 +568,7 @@ next:
     {
         u32 bufRemain = (ctx->bufSize > ctx->n) ? (ctx->bufSize - ctx->n) : 0;
         char* bufPtr = ctx->buf ? (ctx->buf + ctx->n) : NULL;
-        u32 a = TXN_printSL(space, e, bufPtr, bufRemain, ctx->opt->srcInfo);
+        u32 a = TXN_printSlNode(space, e, bufPtr, bufRemain, ctx->opt->srcInfo, (u32)-1);
         TXN_printMlForward(ctx, a);
         break;
     }
@@ -509,20 +586,24 @@ next:
 
 
 
-u32 TXN_printML(const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_PrintMlOpt* opt)
+// depth and column give where node starts, so a node can be printed on its own as part of a bigger document
+static u32 TXN_printMlNode
+(
+    const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_PrintMlOpt* opt, u32 depth, u32 column
+)
 {
     TXN_NodeInfo* info = space->nodes->data + node.id;
     switch (info->type)
     {
     case TXN_NodeType_Tok:
     {
-        return TXN_printSL(space, node, buf, bufSize, opt->srcInfo);
+        return TXN_printSlNode(space, node, buf, bufSize, opt->srcInfo, (u32)-1);
     }
     default:
     {
         TXN_PrintMlContext ctx[1] =
         {
-            { space, opt, bufSize, buf }
+            { space, opt, bufSize, buf, 0, column, depth }
         };
         TXN_printMlSeq(ctx, node);
         TXN_printMlContextFree(ctx);
@@ -532,6 +613,13 @@ u32 TXN_printML(const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, c
 }
 
 
+u32 TXN_printML(const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_PrintMlOpt* opt)
+{
+    TXN_STAT(u64 t0 = TXN_statsNow());
+    u32 n = TXN_printMlNode(space, node, buf, bufSize, opt, 0, 0);
+    TXN_STAT(TXN_spaceStatsOf(space)->cycles[TXN_StatsPhase_PrintML] += TXN_statsNow() - t0);
+    return n;
+}
 
 
 
@@ -545,100 +633,343 @@ u32 TXN_printML(const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, c
 
 
 
+// a task prints elements begin..end of a seq, a task with no elements is bracket and separator text
+// filled in when the document is split
+typedef struct TXN_PrintTask
+{
+    const TXN_Node* elms;
+    TXN_NodeType type;
+    u32 begin;
+    u32 end;
+    u32 depth;
+    u32 column;
+    vec_char out[1];
+} TXN_PrintTask;
 
+typedef vec_t(TXN_PrintTask) TXN_PrintTaskVec;
 
 
+typedef struct TXN_PrintParallelCtx
+{
+    const TXN_Space* space;
+    const TXN_SpaceSrcInfo* srcInfo;
+    const TXN_PrintMlOpt* mlOpt;
+    TXN_PrintTask* tasks;
+    u32 tasksTotal;
+    volatile u32 next;
+} TXN_PrintParallelCtx;
 
 
 
+static void TXN_printTaskIndent(const TXN_PrintMlOpt* mlOpt, vec_char* out, u32 depth)
+{
+    for (u32 i = 0; i < mlOpt->indent * depth; ++i)
+    {
+        vec_push(out, ' ');
+    }
+}
 
+// what goes before element p of a seq, the element then starts at its column
+static u32 TXN_printTaskSep
+(
+    const TXN_PrintMlOpt* mlOpt, vec_char* out, TXN_NodeType type, u32 p, u32 depth, u32 column
+)
+{
+    if (!mlOpt)
+    {
+        if (p > 0)
+        {
+            vec_push(out, ' ');
+        }
+        return 0;
+    }
+    if (p > 0)
+    {
+        vec_push(out, '\n');
+    }
+    if ((p > 0) || (type != TXN_NodeType_SeqRound))
+    {
+        TXN_printTaskIndent(mlOpt, out, depth);
+        return mlOpt->indent * depth;
+    }
+    return column;
+}
 
 
+static void TXN_printTaskElm(TXN_PrintParallelCtx* ctx, TXN_PrintTask* task, TXN_Node e, u32 column)
+{
+    vec_char* out = task->out;
+    for (;;)
+    {
+        u32 room = out->capacity - out->length;
+        char* ptr = out->data + out->length;
+        u32 a;
+        if (ctx->mlOpt)
+        {
+            a = TXN_printMlNode(ctx->space, e, ptr, room, ctx->mlOpt, task->depth, column);
+        }
+        else
+        {
+            a = TXN_printSlNode(ctx->space, e, ptr, room, ctx->srcInfo, (u32)-1);
+        }
+        if (a < room)
+        {
+            out->length += a;
+            return;
+        }
+        vec_reserve(out, out->length + a + 1);
+    }
+}
 
 
+static void TXN_printParallelWorker(void* arg, u32 worker)
+{
+    TXN_PrintParallelCtx* ctx = arg;
+    for (;;)
+    {
+        u32 i = TXN_atomicInc(&ctx->next);
+        if (i >= ctx->tasksTotal)
+        {
+            break;
+        }
+        TXN_PrintTask* task = ctx->tasks + i;
+        if (task->begin == task->end)
+        {
+            continue;
+        }
+        vec_reserve(task->out, 4096);
+        for (u32 p = task->begin; p < task->end; ++p)
+        {
+            u32 column = TXN_printTaskSep(ctx->mlOpt, task->out, task->type, p, task->depth, task->column);
+            TXN_printTaskElm(ctx, task, task->elms[p], column);
+        }
+    }
+}
 
 
 
 
+typedef struct TXN_PrintSplitLevel
+{
+    TXN_Node src;
+    u32 p;
+    u32 depth;
+    u32 column;
+} TXN_PrintSplitLevel;
 
+typedef vec_t(TXN_PrintSplitLevel) TXN_PrintSplitStack;
 
 
+// text between element tasks goes into a trailing task with no elements
+static vec_char* TXN_printSplitText(TXN_PrintTaskVec* tasks)
+{
+    if (!tasks->length || (vec_last(tasks).begin != vec_last(tasks).end))
+    {
+        TXN_PrintTask task = { 0 };
+        vec_push(tasks, task);
+    }
+    return vec_last(tasks).out;
+}
 
+// a big seq is split into its elements, in ML only once it is known not to fit on the rest of its line,
+// then every element starts at a known column like the naked root ones do
+static bool TXN_printSplitSeq
+(
+    const TXN_Space* space, TXN_Node node, const TXN_SpaceSrcInfo* srcInfo, const TXN_PrintMlOpt* mlOpt,
+    u32 grain, u32 column
+)
+{
+    if (TXN_nodeIsTok(space, node) || (TXN_nodeEstSize(space, node) <= grain))
+    {
+        return false;
+    }
+    if (!mlOpt)
+    {
+        return true;
+    }
+    u32 limit = (mlOpt->width > column) ? (mlOpt->width - column) : 0;
+    return TXN_printSlNode(space, node, NULL, 0, srcInfo, limit) > limit;
+}
 
+static void TXN_printSplitOpen
+(
+    TXN_PrintSplitStack* stack, TXN_PrintTaskVec* tasks, const TXN_Space* space, const TXN_PrintMlOpt* mlOpt,
+    TXN_Node src, u32 depth, u32 column
+)
+{
+    const TXN_NodeInfo* info = space->nodes->data + src.id;
+    char ch[2] = { 0 };
+    TXN_seqBracketChs(info->type, ch);
+    if (ch[0])
+    {
+        vec_char* out = TXN_printSplitText(tasks);
+        vec_push(out, ch[0]);
+        ++column;
+        if (mlOpt)
+        {
+            if (info->type != TXN_NodeType_SeqRound)
+            {
+                vec_push(out, '\n');
+            }
+            ++depth;
+        }
+    }
+    TXN_PrintSplitLevel l = { src, 0, depth, column };
+    vec_push(stack, l);
+}
 
+static void TXN_printSplitClose
+(
+    TXN_PrintTaskVec* tasks, const TXN_Space* space, const TXN_PrintMlOpt* mlOpt, const TXN_PrintSplitLevel* l
+)
+{
+    const TXN_NodeInfo* info = space->nodes->data + l->src.id;
+    char ch[2] = { 0 };
+    TXN_seqBracketChs(info->type, ch);
+    vec_char* out = TXN_printSplitText(tasks);
+    if (!mlOpt || (TXN_NodeType_SeqRound == info->type))
+    {
+        if (ch[1])
+        {
+            vec_push(out, ch[1]);
+        }
+        return;
+    }
+    vec_push(out, '\n');
+    if (ch[1])
+    {
+        TXN_printTaskIndent(mlOpt, out, l->depth - 1);
+        vec_push(out, ch[1]);
+    }
+}
 
 
+// cuts the document into runs of about grain nodes, splitting big seqs down to their elements
+static void TXN_printSplit
+(
+    TXN_PrintTaskVec* tasks, const TXN_Space* space, TXN_Node root, const TXN_SpaceSrcInfo* srcInfo,
+    const TXN_PrintMlOpt* mlOpt, u32 grain
+)
+{
+    TXN_PrintSplitStack stack[1] = { 0 };
+    TXN_printSplitOpen(stack, tasks, space, mlOpt, root, 0, 0);
+    while (stack->length)
+    {
+        TXN_PrintSplitLevel* top = &vec_last(stack);
+        const TXN_NodeInfo* info = space->nodes->data + top->src.id;
+        const TXN_Node* elms = upool_elmData(space->dataPool, info->offset);
+        if (top->p == info->length)
+        {
+            TXN_printSplitClose(tasks, space, mlOpt, top);
+            vec_pop(stack);
+            continue;
+        }
 
+        u32 p = top->p;
+        u32 size = 0;
+        for (; (p < info->length) && (size < grain); ++p)
+        {
+            u32 column = top->column;
+            if (mlOpt && ((p > 0) || (info->type != TXN_NodeType_SeqRound)))
+            {
+                column = mlOpt->indent * top->depth;
+            }
+            if (TXN_printSplitSeq(space, elms[p], srcInfo, mlOpt, grain, column))
+            {
+                break;
+            }
+            size += TXN_nodeEstSize(space, elms[p]);
+        }
+        if (p > top->p)
+        {
+            TXN_PrintTask task = { elms, info->type, top->p, p, top->depth, top->column };
+            vec_push(tasks, task);
+            top->p = p;
+            continue;
+        }
 
+        TXN_PrintSplitLevel l = *top;
+        ++top->p;
+        u32 column = TXN_printTaskSep(mlOpt, TXN_printSplitText(tasks), info->type, p, l.depth, l.column);
+        TXN_printSplitOpen(stack, tasks, space, mlOpt, elms[p], l.depth, column);
+    }
+    vec_free(stack);
+}
 
 
 
+static u32 TXN_printParallel
+(
+    const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize,
+    const TXN_SpaceSrcInfo* srcInfo, const TXN_PrintMlOpt* mlOpt, const TXN_ParallelOpt* opt
+)
+{
+    u32 threads = (opt && opt->threads) ? opt->threads : TXN_cpuCount();
+    u32 grain = (opt && opt->grain) ? opt->grain : TXN_ParallelGrain_Default;
 
+    TXN_PrintTaskVec tasks[1] = { 0 };
+    TXN_printSplit(tasks, space, node, srcInfo, mlOpt, grain);
 
+    TXN_PrintParallelCtx ctx[1] = { { space, srcInfo, mlOpt, tasks->data, tasks->length, 0 } };
+    threads = min(threads, tasks->length);
+    if (threads > 1)
+    {
+        TXN_runWorkers(threads, TXN_printParallelWorker, ctx);
+    }
+    else
+    {
+        TXN_printParallelWorker(ctx, 0);
+    }
 
+    u32 n = 0;
+    u32 bufRemain = (buf && bufSize) ? (bufSize - 1) : 0;
+    for (u32 i = 0; i < tasks->length; ++i)
+    {
+        vec_char* out = tasks->data[i].out;
+        u32 wn = min(bufRemain, out->length);
+        if (wn > 0)
+        {
+            memcpy(buf + n, out->data, wn);
+            bufRemain -= wn;
+        }
+        n += out->length;
+        vec_free(out);
+    }
+    if (buf && bufSize)
+    {
+        buf[min(n, bufSize - 1)] = 0;
+    }
+    vec_free(tasks);
+    return n;
+}
 
 
 
+u32 TXN_printSlParallel
+(
+    const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_SpaceSrcInfo* srcInfo,
+    const TXN_ParallelOpt* opt
+)
+{
+    u32 grain = (opt && opt->grain) ? opt->grain : TXN_ParallelGrain_Default;
+    if (!TXN_printSplitSeq(space, node, srcInfo, NULL, grain, 0))
+    {
+        return TXN_printSL(space, node, buf, bufSize, srcInfo);
+    }
+    return TXN_printParallel(space, node, buf, bufSize, srcInfo, NULL, opt);
+}
 
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+u32 TXN_printMlParallel
+(
+    const TXN_Space* space, TXN_Node node, char* buf, u32 bufSize, const TXN_PrintMlOpt* mlOpt,
+    const TXN_ParallelOpt* opt
+)
+{
+    u32 grain = (opt && opt->grain) ? opt->grain : TXN_ParallelGrain_Default;
+    if (!TXN_printSplitSeq(space, node, mlOpt->srcInfo, mlOpt, grain, 0))
+    {
+        return TXN_printML(space, node, buf, bufSize, mlOpt);
+    }
+    return TXN_printParallel(space, node, buf, bufSize, mlOpt->srcInfo, mlOpt, opt);
+}
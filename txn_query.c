@@ -0,0 +1,592 @@
+#include "txn_a.h"
+
+
+
+
+typedef struct TXN_TokIndexEntry
+{
+    u32 dataId;
+    u32 hash;
+    u32 next;
+    u32 begin;
+    u32 count;
+    u32 lastSeq;
+} TXN_TokIndexEntry;
+
+typedef vec_t(TXN_TokIndexEntry) TXN_TokIndexEntryVec;
+
+
+typedef struct TXN_TokIndexPair
+{
+    u32 entry;
+    TXN_Node seq;
+} TXN_TokIndexPair;
+
+typedef vec_t(TXN_TokIndexPair) TXN_TokIndexPairVec;
+
+
+typedef struct TXN_TokIndex
+{
+    const TXN_Space* space;
+    TXN_Node root;
+    TXN_TokIndexEntryVec entrys[1];
+    TXN_IdMap idMap[1];
+    TXN_IdMap hashMap[1];
+    TXN_NodeVec postings[1];
+} TXN_TokIndex;
+
+
+
+
+TXN_TokIndex* TXN_tokIndexNew(const TXN_Space* space, TXN_Node root)
+{
+    TXN_TokIndex* index = zalloc(sizeof(*index));
+    index->space = space;
+    index->root = root;
+
+    TXN_TokIndexPairVec pairs[1] = { 0 };
+    TXN_NodeVec stack[1] = { 0 };
+    vec_push(stack, root);
+    while (stack->length > 0)
+    {
+        TXN_Node node = vec_last(stack);
+        vec_pop(stack);
+        const TXN_NodeInfo* info = space->nodes->data + node.id;
+        if (TXN_NodeType_Tok == info->type)
+        {
+            continue;
+        }
+        const TXN_Node* elms = upool_elmData(space->dataPool, info->offset);
+        for (u32 i = 0; i < info->length; ++i)
+        {
+            const TXN_NodeInfo* eInfo = space->nodes->data + elms[i].id;
+            if (eInfo->type != TXN_NodeType_Tok)
+            {
+                continue;
+            }
+            bool isNew;
+            u32* pEntry = TXN_idMapPut(index->idMap, eInfo->offset, index->entrys->length, &isNew);
+            if (isNew)
+            {
+                const char* str = TXN_tokDataAt(space, eInfo->offset);
+                TXN_TokIndexEntry e = { eInfo->offset, TXN_hashBytes(str, eInfo->length), (u32)-1, 0, 0, (u32)-1 };
+                u32* pHead = TXN_idMapPut(index->hashMap, e.hash, *pEntry, &isNew);
+                if (!isNew)
+                {
+                    e.next = *pHead;
+                    *pHead = *pEntry;
+                }
+                vec_push(index->entrys, e);
+            }
+            TXN_TokIndexEntry* e = index->entrys->data + *pEntry;
+            if (e->lastSeq == node.id)
+            {
+                continue;
+            }
+            e->lastSeq = node.id;
+            ++e->count;
+            TXN_TokIndexPair pair = { *pEntry, node };
+            vec_push(pairs, pair);
+        }
+        for (u32 i = 0; i < info->length; ++i)
+        {
+            vec_push(stack, elms[info->length - 1 - i]);
+        }
+    }
+    vec_free(stack);
+
+    u32 begin = 0;
+    for (u32 i = 0; i < index->entrys->length; ++i)
+    {
+        TXN_TokIndexEntry* e = index->entrys->data + i;
+        e->begin = begin;
+        begin += e->count;
+        e->count = 0;
+    }
+    vec_resize(index->postings, pairs->length);
+    for (u32 i = 0; i < pairs->length; ++i)
+    {
+        TXN_TokIndexEntry* e = index->entrys->data + pairs->data[i].entry;
+        index->postings->data[e->begin + e->count++] = pairs->data[i].seq;
+    }
+    vec_free(pairs);
+    return index;
+}
+
+
+void TXN_tokIndexFree(TXN_TokIndex* index)
+{
+    vec_free(index->postings);
+    TXN_idMapFree(index->hashMap);
+    TXN_idMapFree(index->idMap);
+    vec_free(index->entrys);
+    free(index);
+}
+
+
+
+static const TXN_TokIndexEntry* TXN_tokIndexFind(const TXN_TokIndex* index, const char* str, u32 len)
+{
+    const TXN_Space* space = index->space;
+    u32* pHead = TXN_idMapGet(index->hashMap, TXN_hashBytes(str, len));
+    if (!pHead)
+    {
+        return NULL;
+    }
+    for (u32 i = *pHead; i != (u32)-1; i = index->entrys->data[i].next)
+    {
+        const TXN_TokIndexEntry* e = index->entrys->data + i;
+        const char* eStr = TXN_tokDataAt(space, e->dataId);
+        if ((0 == memcmp(eStr, str, len)) && !eStr[len])
+        {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+
+
+
+
+
+
+
+
+
+
+typedef enum TXN_QueryOpType
+{
+    TXN_QueryOpType_Any,
+    TXN_QueryOpType_Type,
+    TXN_QueryOpType_Tok,
+    TXN_QueryOpType_Seq,
+    TXN_QueryOpType_Capture,
+    TXN_QueryOpType_Desc,
+} TXN_QueryOpType;
+
+typedef struct TXN_QueryOp
+{
+    TXN_QueryOpType type;
+    u32 arg;
+    u32 len;
+    bool rest;
+    u32 size;
+} TXN_QueryOp;
+
+typedef vec_t(TXN_QueryOp) TXN_QueryOpVec;
+
+
+typedef struct TXN_QueryLit
+{
+    u32 offset;
+    u32 len;
+    u32 dataId;
+} TXN_QueryLit;
+
+typedef vec_t(TXN_QueryLit) TXN_QueryLitVec;
+
+
+typedef struct TXN_Query
+{
+    TXN_QueryOpVec ops[1];
+    TXN_QueryLitVec lits[1];
+    vec_char litData[1];
+    u32 capsTotal;
+
+    const TXN_Space* space;
+    TXN_Node* caps;
+    TXN_NodeVec stack[1];
+} TXN_Query;
+
+
+
+
+static bool TXN_queryTokIs(const TXN_Space* space, TXN_Node node, const char* s)
+{
+    return 0 == strcmp(TXN_tokData(space, node), s);
+}
+
+
+static bool TXN_queryCompile(TXN_Query* query, const TXN_Space* space, const TXN_Node* elms, u32 len, u32* pi)
+{
+    if (*pi >= len)
+    {
+        return false;
+    }
+    TXN_Node node = elms[(*pi)++];
+    u32 p = query->ops->length;
+    TXN_QueryOp op = { TXN_QueryOpType_Any };
+    vec_push(query->ops, op);
+
+    if (TXN_nodeIsTok(space, node))
+    {
+        const char* str = TXN_tokData(space, node);
+        u32 strLen = TXN_tokSize(space, node);
+        if (TXN_tokQuoted(space, node))
+        {
+            op.type = TXN_QueryOpType_Tok;
+        }
+        else if (TXN_queryTokIs(space, node, "_"))
+        {
+            op.type = TXN_QueryOpType_Any;
+        }
+        else if (TXN_queryTokIs(space, node, "$"))
+        {
+            op.type = TXN_QueryOpType_Capture;
+            op.arg = query->capsTotal++;
+            if (!TXN_queryCompile(query, space, elms, len, pi))
+            {
+                return false;
+            }
+        }
+        else if (TXN_queryTokIs(space, node, "**"))
+        {
+            op.type = TXN_QueryOpType_Desc;
+            if (!TXN_queryCompile(query, space, elms, len, pi))
+            {
+                return false;
+            }
+        }
+        else if ('%' == str[0])
+        {
+            static const char* names[] = { "tok", "naked", "round", "square", "curly", "seq" };
+            op.type = TXN_QueryOpType_Type;
+            for (u32 i = 0; i < ARYLEN(names); ++i)
+            {
+                if (0 == strcmp(str + 1, names[i]))
+                {
+                    op.arg = (i < TXN_NumNodeTypes) ? (1u << i) : ~1u;
+                    break;
+                }
+            }
+            if (!op.arg)
+            {
+                return false;
+            }
+        }
+        else if (TXN_queryTokIs(space, node, "..."))
+        {
+            return false;
+        }
+        else
+        {
+            op.type = TXN_QueryOpType_Tok;
+        }
+        if (TXN_QueryOpType_Tok == op.type)
+        {
+            op.arg = query->lits->length;
+            TXN_QueryLit lit = { query->litData->length, strLen, (u32)-1 };
+            vec_push(query->lits, lit);
+            vec_pusharr(query->litData, str, strLen + 1);
+        }
+    }
+    else
+    {
+        const TXN_Node* subElms = TXN_seqElm(space, node);
+        u32 subLen = TXN_seqLen(space, node);
+        op.type = TXN_QueryOpType_Seq;
+        op.arg = TXN_nodeType(space, node);
+        for (u32 i = 0; i < subLen;)
+        {
+            TXN_Node e = subElms[i];
+            if (TXN_nodeIsTok(space, e) && !TXN_tokQuoted(space, e) && TXN_queryTokIs(space, e, "..."))
+            {
+                if (i + 1 != subLen)
+                {
+                    return false;
+                }
+                op.rest = true;
+                break;
+            }
+            if (!TXN_queryCompile(query, space, subElms, subLen, &i))
+            {
+                return false;
+            }
+            ++op.len;
+        }
+    }
+    op.size = query->ops->length - p;
+    query->ops->data[p] = op;
+    return true;
+}
+
+
+TXN_Query* TXN_queryNew(const char* src)
+{
+    TXN_Space* space = TXN_spaceNew();
+    TXN_Node root = TXN_parseAsList(space, src, NULL);
+    if (TXN_Node_Invalid.id == root.id)
+    {
+        TXN_spaceFree(space);
+        return NULL;
+    }
+    TXN_Query* query = zalloc(sizeof(*query));
+    u32 i = 0;
+    u32 len = TXN_seqLen(space, root);
+    bool ok = TXN_queryCompile(query, space, TXN_seqElm(space, root), len, &i);
+    TXN_spaceFree(space);
+    if (!ok || (i != len))
+    {
+        TXN_queryFree(query);
+        return NULL;
+    }
+    query->caps = zalloc(sizeof(TXN_Node)*max(query->capsTotal, 1));
+    return query;
+}
+
+
+void TXN_queryFree(TXN_Query* query)
+{
+    vec_free(query->stack);
+    free(query->caps);
+    vec_free(query->litData);
+    vec_free(query->lits);
+    vec_free(query->ops);
+    free(query);
+}
+
+
+u32 TXN_queryCapturesTotal(const TXN_Query* query)
+{
+    return query->capsTotal;
+}
+
+
+
+
+
+static void TXN_queryBind(TXN_Query* query, const TXN_Space* space)
+{
+    query->space = space;
+    for (u32 i = 0; i < query->lits->length; ++i)
+    {
+        query->lits->data[i].dataId = (u32)-1;
+    }
+}
+
+
+static bool TXN_queryLitEq(TXN_Query* query, TXN_QueryLit* lit, const TXN_NodeInfo* info)
+{
+    if (lit->dataId != (u32)-1)
+    {
+        return lit->dataId == info->offset;
+    }
+    if (lit->len != info->length)
+    {
+        return false;
+    }
+    const char* str = TXN_tokDataAt(query->space, info->offset);
+    if (0 == memcmp(str, query->litData->data + lit->offset, lit->len))
+    {
+        lit->dataId = info->offset;
+        return true;
+    }
+    return false;
+}
+
+
+static bool TXN_queryMatchDesc(TXN_Query* query, u32 pc, TXN_Node node);
+
+static bool TXN_queryMatchOp(TXN_Query* query, u32 pc, TXN_Node node)
+{
+    const TXN_Space* space = query->space;
+    const TXN_QueryOp* op = query->ops->data + pc;
+    const TXN_NodeInfo* info = space->nodes->data + node.id;
+    switch (op->type)
+    {
+    case TXN_QueryOpType_Any:
+        return true;
+    case TXN_QueryOpType_Type:
+        return (op->arg & (1u << info->type)) != 0;
+    case TXN_QueryOpType_Tok:
+        if (info->type != TXN_NodeType_Tok)
+        {
+            return false;
+        }
+        return TXN_queryLitEq(query, query->lits->data + op->arg, info);
+    case TXN_QueryOpType_Seq:
+    {
+        if (info->type != op->arg)
+        {
+            return false;
+        }
+        if (op->rest ? (info->length < op->len) : (info->length != op->len))
+        {
+            return false;
+        }
+        const TXN_Node* elms = upool_elmData(space->dataPool, info->offset);
+        u32 len = op->len;
+        u32 epc = pc + 1;
+        for (u32 i = 0; i < len; ++i)
+        {
+            if (!TXN_queryMatchOp(query, epc, elms[i]))
+            {
+                return false;
+            }
+            epc += query->ops->data[epc].size;
+        }
+        return true;
+    }
+    case TXN_QueryOpType_Capture:
+        if (TXN_queryMatchOp(query, pc + 1, node))
+        {
+            query->caps[query->ops->data[pc].arg] = node;
+            return true;
+        }
+        return false;
+    case TXN_QueryOpType_Desc:
+        return TXN_queryMatchDesc(query, pc + 1, node);
+    default:
+        assert(false);
+        return false;
+    }
+}
+
+
+static void TXN_queryPushElms(TXN_Query* query, TXN_Node node)
+{
+    const TXN_Space* space = query->space;
+    const TXN_NodeInfo* info = space->nodes->data + node.id;
+    if (TXN_NodeType_Tok == info->type)
+    {
+        return;
+    }
+    const TXN_Node* elms = upool_elmData(space->dataPool, info->offset);
+    for (u32 i = 0; i < info->length; ++i)
+    {
+        vec_push(query->stack, elms[info->length - 1 - i]);
+    }
+}
+
+
+static bool TXN_queryMatchDesc(TXN_Query* query, u32 pc, TXN_Node node)
+{
+    TXN_NodeVec* stack = query->stack;
+    u32 base = stack->length;
+    vec_push(stack, node);
+    while (stack->length > base)
+    {
+        TXN_Node e = vec_last(stack);
+        vec_pop(stack);
+        if (TXN_queryMatchOp(query, pc, e))
+        {
+            vec_resize(stack, base);
+            return true;
+        }
+        TXN_queryPushElms(query, e);
+    }
+    return false;
+}
+
+
+
+
+bool TXN_queryMatch(TXN_Query* query, const TXN_Space* space, TXN_Node node, TXN_Node* caps)
+{
+    TXN_queryBind(query, space);
+    bool ok = TXN_queryMatchOp(query, 0, node);
+    if (ok && caps)
+    {
+        memcpy(caps, query->caps, sizeof(TXN_Node)*query->capsTotal);
+    }
+    return ok;
+}
+
+
+
+
+static bool TXN_queryIndexEntry(TXN_Query* query, const TXN_TokIndex* index, u32 pc, const TXN_TokIndexEntry** pEntry)
+{
+    const TXN_QueryOp* op = query->ops->data + pc;
+    while (TXN_QueryOpType_Capture == op->type)
+    {
+        ++op;
+    }
+    if (op->type != TXN_QueryOpType_Seq)
+    {
+        return false;
+    }
+    const TXN_QueryOp* e = op + 1;
+    for (u32 i = 0; i < op->len; ++i)
+    {
+        const TXN_QueryOp* x = e;
+        while (TXN_QueryOpType_Capture == x->type)
+        {
+            ++x;
+        }
+        if (TXN_QueryOpType_Tok == x->type)
+        {
+            TXN_QueryLit* lit = query->lits->data + x->arg;
+            *pEntry = TXN_tokIndexFind(index, query->litData->data + lit->offset, lit->len);
+            if (*pEntry)
+            {
+                lit->dataId = (*pEntry)->dataId;
+            }
+            return true;
+        }
+        e += e->size;
+    }
+    return false;
+}
+
+
+u32 TXN_queryExec
+(
+    TXN_Query* query, const TXN_Space* space, TXN_Node root, const TXN_TokIndex* index,
+    TXN_QueryCallback cb, void* ctx
+)
+{
+    TXN_queryBind(query, space);
+    TXN_NodeVec* stack = query->stack;
+    u32 n = 0;
+    if (query->ops->data[0].type != TXN_QueryOpType_Desc)
+    {
+        if (TXN_queryMatchOp(query, 0, root))
+        {
+            ++n;
+            if (cb) cb(ctx, root, query->caps, query->capsTotal);
+        }
+        return n;
+    }
+    const TXN_TokIndexEntry* entry = NULL;
+    if (index && (index->space == space) && (index->root.id == root.id) &&
+        TXN_queryIndexEntry(query, index, 1, &entry))
+    {
+        if (!entry)
+        {
+            return n;
+        }
+        const TXN_Node* cands = index->postings->data + entry->begin;
+        for (u32 i = 0; i < entry->count; ++i)
+        {
+            if (TXN_queryMatchOp(query, 1, cands[i]))
+            {
+                ++n;
+                if (cb && !cb(ctx, cands[i], query->caps, query->capsTotal))
+                {
+                    break;
+                }
+            }
+        }
+        return n;
+    }
+    vec_resize(stack, 0);
+    vec_push(stack, root);
+    while (stack->length > 0)
+    {
+        TXN_Node e = vec_last(stack);
+        vec_pop(stack);
+        if (TXN_queryMatchOp(query, 1, e))
+        {
+            ++n;
+            if (cb && !cb(ctx, e, query->caps, query->capsTotal))
+            {
+                break;
+            }
+        }
+        TXN_queryPushElms(query, e);
+    }
+    vec_resize(stack, 0);
+    return n;
+}
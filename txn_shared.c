@@ -0,0 +1,141 @@
+#include "txn_a.h"
+
+
+
+
+TXN_SharedPool* TXN_sharedPoolNew(void)
+{
+    TXN_SharedPool* pool = zalloc(sizeof(*pool));
+    return pool;
+}
+
+void TXN_sharedPoolFree(TXN_SharedPool* pool)
+{
+    vec_free(pool->slots);
+    vec_free(pool->syms);
+    vec_free(pool->data);
+    free(pool);
+}
+
+
+
+
+static void TXN_sharedPoolRehash(TXN_SharedPool* pool, u32 n)
+{
+    vec_resize(pool->slots, n);
+    memset(pool->slots->data, 0xff, sizeof(u32)*n);
+    u32 mask = n - 1;
+    for (u32 s = 0; s < pool->syms->length; ++s)
+    {
+        const TXN_SymInfo* info = pool->syms->data + s;
+        u32 i = TXN_hashBytes(pool->data->data + info->offset, info->length) & mask;
+        while (pool->slots->data[i] != (u32)-1)
+        {
+            i = (i + 1) & mask;
+        }
+        pool->slots->data[i] = s;
+    }
+}
+
+// the slot holding the payload, or the empty one where it would go
+static u32 TXN_sharedPoolSlot(const TXN_SharedPool* pool, const void* data, u32 len)
+{
+    u32 mask = pool->slots->length - 1;
+    for (u32 i = TXN_hashBytes(data, len) & mask;; i = (i + 1) & mask)
+    {
+        u32 s = pool->slots->data[i];
+        if (s == (u32)-1)
+        {
+            return i;
+        }
+        const TXN_SymInfo* info = pool->syms->data + s;
+        if ((info->length == len) && (0 == memcmp(pool->data->data + info->offset, data, len)))
+        {
+            return i;
+        }
+    }
+}
+
+
+
+
+u32 TXN_sharedPoolAdd(TXN_SharedPool* pool, const char* ptr, u32 len)
+{
+    assert(!pool->frozen);
+    if ((pool->syms->length + 1) * 2 > pool->slots->length)
+    {
+        TXN_sharedPoolRehash(pool, max(16, pool->slots->length * 2));
+    }
+    u32* slot = pool->slots->data + TXN_sharedPoolSlot(pool, ptr, len);
+    if (*slot != (u32)-1)
+    {
+        return *slot;
+    }
+    TXN_SymInfo info = { pool->data->length, len };
+    assert(!((info.offset + len + 1) & TXN_SharedDataBit));
+    vec_pusharr(pool->data, ptr, len);
+    vec_push(pool->data, 0);
+    *slot = pool->syms->length;
+    vec_push(pool->syms, info);
+    return *slot;
+}
+
+void TXN_sharedPoolFreeze(TXN_SharedPool* pool)
+{
+    vec_compact(pool->data);
+    vec_compact(pool->syms);
+    pool->frozen = true;
+}
+
+u32 TXN_sharedPoolSymsTotal(const TXN_SharedPool* pool)
+{
+    return pool->syms->length;
+}
+
+
+u32 TXN_sharedPoolFind(const TXN_SharedPool* pool, const void* data, u32 len)
+{
+    assert(pool->frozen);
+    if (!pool->slots->length)
+    {
+        return (u32)-1;
+    }
+    return pool->slots->data[TXN_sharedPoolSlot(pool, data, len)];
+}
+
+
+
+
+TXN_Space* TXN_spaceNewShared(const TXN_SharedPool* pool)
+{
+    assert(pool->frozen);
+    TXN_Space* space = TXN_spaceNew();
+    space->shared = pool;
+    space->view->sharedBase = pool->data->data;
+    return space;
+}
+
+
+
+
+bool TXN_tokEq(const TXN_Space* spaceA, TXN_Node a, const TXN_Space* spaceB, TXN_Node b)
+{
+    const TXN_NodeInfo* aInfo = spaceA->nodes->data + a.id;
+    const TXN_NodeInfo* bInfo = spaceB->nodes->data + b.id;
+    assert(TXN_NodeType_Tok == aInfo->type);
+    assert(TXN_NodeType_Tok == bInfo->type);
+    if (spaceA == spaceB)
+    {
+        return aInfo->offset == bInfo->offset;
+    }
+    // a payload in the shared pool is never interned into the own pool of a space attached to it
+    if (spaceA->shared && (spaceA->shared == spaceB->shared) && ((aInfo->offset | bInfo->offset) & TXN_SharedDataBit))
+    {
+        return aInfo->offset == bInfo->offset;
+    }
+    if (aInfo->length != bInfo->length)
+    {
+        return false;
+    }
+    return 0 == memcmp(TXN_tokDataAt(spaceA, aInfo->offset), TXN_tokDataAt(spaceB, bInfo->offset), aInfo->length);
+}
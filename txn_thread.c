@@ -0,0 +1,105 @@
+#include "txn_a.h"
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# define NOMINMAX
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
+
+
+
+u32 TXN_cpuCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (u32)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (u32)n : 1;
+#endif
+}
+
+
+u32 TXN_atomicInc(volatile u32* p)
+{
+#ifdef _WIN32
+    return (u32)InterlockedIncrement((volatile LONG*)p) - 1;
+#else
+    return __atomic_fetch_add(p, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+
+
+
+typedef struct TXN_Worker
+{
+    TXN_WorkerFn fn;
+    void* ctx;
+    u32 id;
+} TXN_Worker;
+
+
+#ifdef _WIN32
+static DWORD WINAPI TXN_workerMain(LPVOID arg)
+#else
+static void* TXN_workerMain(void* arg)
+#endif
+{
+    TXN_Worker* worker = arg;
+    worker->fn(worker->ctx, worker->id);
+    return 0;
+}
+
+
+
+void TXN_runWorkers(u32 n, TXN_WorkerFn fn, void* ctx)
+{
+    assert(n > 0);
+    TXN_Worker* workers = zalloc(sizeof(*workers) * n);
+#ifdef _WIN32
+    HANDLE* threads = zalloc(sizeof(*threads) * n);
+#else
+    pthread_t* threads = zalloc(sizeof(*threads) * n);
+    bool* started = zalloc(sizeof(*started) * n);
+#endif
+    for (u32 i = 0; i < n; ++i)
+    {
+        TXN_Worker w = { fn, ctx, i };
+        workers[i] = w;
+    }
+    for (u32 i = 1; i < n; ++i)
+    {
+#ifdef _WIN32
+        threads[i] = CreateThread(NULL, 0, TXN_workerMain, workers + i, 0, NULL);
+#else
+        started[i] = 0 == pthread_create(threads + i, NULL, TXN_workerMain, workers + i);
+#endif
+    }
+    TXN_workerMain(workers);
+    for (u32 i = 1; i < n; ++i)
+    {
+#ifdef _WIN32
+        if (threads[i])
+        {
+            WaitForSingleObject(threads[i], INFINITE);
+            CloseHandle(threads[i]);
+        }
+#else
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+#endif
+    }
+#ifndef _WIN32
+    free(started);
+#endif
+    free(threads);
+    free(workers);
+}
@@ -0,0 +1,296 @@
+#include "txn_a.h"
+
+
+
+
+typedef struct TXN_VisitLevel
+{
+    TXN_Node node;
+    u32 p;
+} TXN_VisitLevel;
+
+typedef vec_t(TXN_VisitLevel) TXN_VisitStack;
+
+
+typedef struct TXN_Visitor
+{
+    TXN_VisitStack stack[1];
+    vec_u32 doneBits[1];
+    TXN_NodeVec doneList[1];
+} TXN_Visitor;
+
+
+
+TXN_Visitor* TXN_visitorNew(void)
+{
+    TXN_Visitor* visitor = zalloc(sizeof(*visitor));
+    return visitor;
+}
+
+void TXN_visitorFree(TXN_Visitor* visitor)
+{
+    vec_free(visitor->doneList);
+    vec_free(visitor->doneBits);
+    vec_free(visitor->stack);
+    free(visitor);
+}
+
+
+
+
+
+bool TXN_visit
+(
+    TXN_Visitor* visitor, const TXN_Space* space, TXN_Node root,
+    TXN_VisitEnterCallback enter, TXN_VisitLeaveCallback leave, void* ctx
+)
+{
+    TXN_VisitStack* stack = visitor->stack;
+    vec_clear(stack);
+
+    TXN_VisitLevel* top = NULL;
+    const TXN_NodeInfo* info = NULL;
+    TXN_Node node = root;
+    u32 depth = 0;
+enter:
+    if (enter)
+    {
+        TXN_VisitAct act = enter(ctx, node, depth);
+        if (TXN_VisitAct_Stop == act)
+        {
+            vec_clear(stack);
+            return false;
+        }
+        if (TXN_VisitAct_Skip == act)
+        {
+            goto next;
+        }
+    }
+    info = space->nodes->data + node.id;
+    if (info->type > TXN_NodeType_Tok)
+    {
+        TXN_VisitLevel l = { node, 0 };
+        vec_push(stack, l);
+        goto next;
+    }
+    if (leave && !leave(ctx, node, depth))
+    {
+        vec_clear(stack);
+        return false;
+    }
+next:
+    if (!stack->length)
+    {
+        return true;
+    }
+    top = &vec_last(stack);
+    info = space->nodes->data + top->node.id;
+    if (top->p < info->length)
+    {
+        const TXN_Node* elms = upool_elmData(space->dataPool, info->offset);
+        node = elms[top->p++];
+        depth = stack->length;
+        goto enter;
+    }
+    node = top->node;
+    vec_pop(stack);
+    depth = stack->length;
+    if (leave && !leave(ctx, node, depth))
+    {
+        vec_clear(stack);
+        return false;
+    }
+    goto next;
+}
+
+
+
+
+
+static bool TXN_visitorIsDone(const TXN_Visitor* visitor, TXN_Node node)
+{
+    return (visitor->doneBits->data[node.id / 32] >> (node.id % 32)) & 1;
+}
+
+static void TXN_visitorMarkDone(TXN_Visitor* visitor, TXN_Node node)
+{
+    visitor->doneBits->data[node.id / 32] |= 1u << (node.id % 32);
+    vec_push(visitor->doneList, node);
+}
+
+static void TXN_visitorDoneReset(TXN_Visitor* visitor, const TXN_Space* space)
+{
+    for (u32 i = 0; i < visitor->doneList->length; ++i)
+    {
+        TXN_Node node = visitor->doneList->data[i];
+        visitor->doneBits->data[node.id / 32] = 0;
+    }
+    vec_clear(visitor->doneList);
+
+    u32 doneWords0 = visitor->doneBits->length;
+    u32 doneWords = (space->nodes->length + 31) / 32;
+    if (doneWords > doneWords0)
+    {
+        vec_resize(visitor->doneBits, doneWords);
+        memset(visitor->doneBits->data + doneWords0, 0, sizeof(u32) * (doneWords - doneWords0));
+    }
+}
+
+
+
+void TXN_fold(TXN_Visitor* visitor, const TXN_Space* space, TXN_Node root, TXN_FoldCallback cb, void* ctx, void* vals)
+{
+    TXN_VisitStack* stack = visitor->stack;
+    vec_clear(stack);
+    TXN_visitorDoneReset(visitor, space);
+
+    TXN_VisitLevel l = { root, 0 };
+    vec_push(stack, l);
+
+    TXN_VisitLevel* top = NULL;
+    const TXN_NodeInfo* info = NULL;
+next:
+    if (!stack->length)
+    {
+        return;
+    }
+    top = &vec_last(stack);
+    info = space->nodes->data + top->node.id;
+    if (info->type > TXN_NodeType_Tok)
+    {
+        const TXN_Node* elms = upool_elmData(space->dataPool, info->offset);
+        while (top->p < info->length)
+        {
+            TXN_Node e = elms[top->p++];
+            if (!TXN_visitorIsDone(visitor, e))
+            {
+                TXN_VisitLevel l = { e, 0 };
+                vec_push(stack, l);
+                goto next;
+            }
+        }
+    }
+    cb(ctx, space, top->node, vals);
+    TXN_visitorMarkDone(visitor, top->node);
+    vec_pop(stack);
+    goto next;
+}
+
+
+
+void TXN_foldAll(const TXN_Space* space, TXN_FoldCallback cb, void* ctx, void* vals)
+{
+    for (u32 i = 0; i < space->nodes->length; ++i)
+    {
+        TXN_Node node = { i };
+        cb(ctx, space, node, vals);
+    }
+}
+
+
+
+
+
+typedef struct TXN_FoldParallelCtx
+{
+    const TXN_Space* space;
+    TXN_FoldCallback cb;
+    void* ctx;
+    void* vals;
+    const TXN_Node* tasks;
+    u32 tasksTotal;
+    volatile u32 next;
+} TXN_FoldParallelCtx;
+
+
+static void TXN_foldParallelWorker(void* arg, u32 worker)
+{
+    TXN_FoldParallelCtx* ctx = arg;
+    TXN_Visitor* visitor = TXN_visitorNew();
+    for (;;)
+    {
+        u32 i = TXN_atomicInc(&ctx->next);
+        if (i >= ctx->tasksTotal)
+        {
+            break;
+        }
+        TXN_fold(visitor, ctx->space, ctx->tasks[i], ctx->cb, ctx->ctx, ctx->vals);
+    }
+    TXN_visitorFree(visitor);
+}
+
+
+static int TXN_nodeIdCmp(const void* a, const void* b)
+{
+    u32 x = ((const TXN_Node*)a)->id;
+    u32 y = ((const TXN_Node*)b)->id;
+    return (x > y) - (x < y);
+}
+
+
+
+void TXN_foldParallel
+(
+    const TXN_Space* space, TXN_Node root, TXN_FoldCallback cb, void* ctx, void* vals,
+    const TXN_ParallelOpt* opt
+)
+{
+    u32 threads = (opt && opt->threads) ? opt->threads : TXN_cpuCount();
+    u32 grain = (opt && opt->grain) ? opt->grain : TXN_ParallelGrain_Default;
+
+    TXN_NodeVec splits[1] = { 0 };
+    TXN_NodeVec tasks[1] = { 0 };
+    TXN_NodeVec stack[1] = { 0 };
+    vec_u32 queued[1] = { 0 };
+    u32 queuedWords = (space->nodes->length + 31) / 32;
+    vec_resize(queued, queuedWords);
+    memset(queued->data, 0, sizeof(u32) * queuedWords);
+
+    vec_push(stack, root);
+    queued->data[root.id / 32] |= 1u << (root.id % 32);
+    while (stack->length)
+    {
+        TXN_Node node = vec_pop(stack);
+        const TXN_NodeInfo* info = space->nodes->data + node.id;
+        if ((info->type == TXN_NodeType_Tok) || (TXN_nodeEstSize(space, node) <= grain))
+        {
+            vec_push(tasks, node);
+            continue;
+        }
+        vec_push(splits, node);
+        const TXN_Node* elms = upool_elmData(space->dataPool, info->offset);
+        for (u32 i = 0; i < info->length; ++i)
+        {
+            TXN_Node e = elms[i];
+            u32 bit = 1u << (e.id % 32);
+            if (!(queued->data[e.id / 32] & bit))
+            {
+                queued->data[e.id / 32] |= bit;
+                vec_push(stack, e);
+            }
+        }
+    }
+
+    TXN_FoldParallelCtx pctx[1] = { { space, cb, ctx, vals, tasks->data, tasks->length, 0 } };
+    threads = min(threads, tasks->length);
+    if (threads > 1)
+    {
+        TXN_runWorkers(threads, TXN_foldParallelWorker, pctx);
+    }
+    else
+    {
+        TXN_foldParallelWorker(pctx, 0);
+    }
+
+    qsort(splits->data, splits->length, sizeof(TXN_Node), TXN_nodeIdCmp);
+    for (u32 i = 0; i < splits->length; ++i)
+    {
+        cb(ctx, space, splits->data[i], vals);
+    }
+
+    vec_free(queued);
+    vec_free(stack);
+    vec_free(tasks);
+    vec_free(splits);
+}
+